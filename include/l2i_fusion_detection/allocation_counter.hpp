@@ -0,0 +1,45 @@
+#ifndef L2I_FUSION_DETECTION__ALLOCATION_COUNTER_HPP_
+#define L2I_FUSION_DETECTION__ALLOCATION_COUNTER_HPP_
+
+#include <cstdint>
+
+namespace l2i_fusion_detection
+{
+
+// Per-thread count of heap allocations made while the thread is tracked. The counting
+// allocation functions (counting_allocator.cpp) are only linked into programs built with
+// L2I_COUNT_ALLOCATIONS, the standalone executable and the tests; in any other process,
+// such as a component container, enabled() is false and the counts stay at zero.
+class AllocationCounter
+{
+public:
+    // True when the running program links the counting allocation functions
+    static bool enabled();
+
+    // Start or stop counting the allocations made by the calling thread
+    static void trackCurrentThread(bool track);
+
+    // Allocations counted on the calling thread so far, including those attributed to it
+    static uint64_t count();
+
+    // Add allocations made by another thread on behalf of the calling thread, e.g. by
+    // worker threads running its parallelFor chunks
+    static void attribute(uint64_t allocations);
+
+    // Called by the counting allocation functions on every allocation
+    static void record();
+};
+
+// Tracks the calling thread for the lifetime of the scope
+class ScopedAllocationTracking
+{
+public:
+    ScopedAllocationTracking() { AllocationCounter::trackCurrentThread(true); }
+    ~ScopedAllocationTracking() { AllocationCounter::trackCurrentThread(false); }
+    ScopedAllocationTracking(const ScopedAllocationTracking&) = delete;
+    ScopedAllocationTracking& operator=(const ScopedAllocationTracking&) = delete;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__ALLOCATION_COUNTER_HPP_
@@ -0,0 +1,106 @@
+#ifndef L2I_FUSION_DETECTION__BOUNDED_QUEUE_HPP_
+#define L2I_FUSION_DETECTION__BOUNDED_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "l2i_fusion_detection/realtime_sync.hpp"
+
+namespace l2i_fusion_detection
+{
+
+// Fixed-capacity FIFO connecting pipeline stages. The ring is allocated once, so pushing
+// and popping never allocate. close() wakes every waiter and makes further pops fail,
+// which is how stage threads are stopped.
+// Each queue has a single producer and a single consumer (calls from different threads
+// must be ordered, as callbacks of one callback group are). The ring takes no lock: two
+// semaphores count the filled and free slots, so a real-time thread handing a frame to a
+// normal priority stage never waits on a lock that stage might hold.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : items_(capacity > 0 ? capacity : 1), free_slots_(static_cast<unsigned int>(items_.size()))
+    {
+    }
+
+    // Append item, waiting while the queue is full; false if the queue was closed
+    bool push(T item)
+    {
+        if (!acquire(free_slots_)) return false;
+        pushSlot(std::move(item));
+        return true;
+    }
+
+    // Append item unless the queue is full or closed
+    bool tryPush(T item)
+    {
+        if (closed_.load() || !free_slots_.tryWait()) return false;
+        pushSlot(std::move(item));
+        return true;
+    }
+
+    // Take the oldest item, waiting while the queue is empty; false once the queue is closed
+    bool pop(T& item)
+    {
+        if (!acquire(filled_slots_)) return false;
+        popSlot(item);
+        return true;
+    }
+
+    // Take the oldest item unless the queue is empty or closed
+    bool tryPop(T& item)
+    {
+        if (closed_.load() || !filled_slots_.tryWait()) return false;
+        popSlot(item);
+        return true;
+    }
+
+    // Wake all waiting threads and refuse further pushes and pops
+    void close()
+    {
+        closed_.store(true);
+        filled_slots_.post();
+        free_slots_.post();
+    }
+
+private:
+    // Wait for a slot; once closed, pass the wake-up on to the next waiter and fail
+    bool acquire(Semaphore& slots)
+    {
+        slots.wait();
+        if (closed_.load()) {
+            slots.post();
+            return false;
+        }
+        return true;
+    }
+
+    // The semaphores order the slot accesses of the two threads
+    void pushSlot(T&& item)
+    {
+        items_[tail_] = std::move(item);
+        tail_ = (tail_ + 1) % items_.size();
+        filled_slots_.post();
+    }
+
+    void popSlot(T& item)
+    {
+        item = std::move(items_[head_]);
+        head_ = (head_ + 1) % items_.size();
+        free_slots_.post();
+    }
+
+    std::vector<T> items_;
+    size_t head_ = 0;  // Consumer side
+    size_t tail_ = 0;  // Producer side
+    std::atomic<bool> closed_{false};
+    Semaphore filled_slots_;
+    Semaphore free_slots_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__BOUNDED_QUEUE_HPP_
@@ -0,0 +1,280 @@
+#ifndef L2I_FUSION_DETECTION__CAMERA_PROJECTION_HPP_
+#define L2I_FUSION_DETECTION__CAMERA_PROJECTION_HPP_
+
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Projects points in the camera frame to pixels with the camera model named by
+// CameraInfo.distortion_model. Pinhole cameras project with the rectified matrix P, like
+// image_geometry::PinholeCameraModel. Equidistant (fisheye) cameras project into the raw
+// image with K and D = [k1, k2, k3, k4]: the distorted radius theta_d(theta) is tabulated
+// once per calibration, so a point costs two square roots and a table lookup instead of
+// an atan and a polynomial. plumb_bob and rational_polynomial cameras project into the raw
+// image through a grid mapping normalized coordinates (x/z, y/z) to distorted pixels, so a
+// point costs a bilinear lookup instead of the distortion polynomial.
+class CameraProjection
+{
+public:
+    enum class Model { Pinhole, Equidistant, DistortionMap };
+
+    // Set up the model from a calibration, unless it is the one already set up; without
+    // use_distortion, plumb_bob and rational_polynomial cameras project with P. Returns
+    // true when the model was rebuilt; tables keep their capacity between calibrations.
+    bool fromCameraInfo(const sensor_msgs::msg::CameraInfo& info, bool use_distortion = true)
+    {
+        if (sameCalibration(info, use_distortion)) return false;
+        distortion_model_ = info.distortion_model;
+        d_ = info.d;
+        k_ = info.k;
+        p_ = info.p;
+        width_ = info.width;
+        height_ = info.height;
+        use_distortion_ = use_distortion;
+
+        const bool equidistant = (info.distortion_model == "equidistant" || info.distortion_model == "fisheye") &&
+                                 info.d.size() >= 4;
+        const bool radial_tangential = (info.distortion_model == "plumb_bob" || info.distortion_model == "rational_polynomial") &&
+                                       info.d.size() >= 5 && info.width > 0 && info.height > 0 &&
+                                       std::any_of(info.d.begin(), info.d.end(), [](double coefficient) { return coefficient != 0.0; });
+        if (radial_tangential && use_distortion) {
+            model_ = Model::DistortionMap;
+            fx_ = info.k[0];
+            skew_ = info.k[1];
+            cx_ = info.k[2];
+            fy_ = info.k[4];
+            cy_ = info.k[5];
+            tx_ = ty_ = 0.0;
+            buildDistortionMap();
+            return true;
+        }
+        if (!equidistant) {
+            model_ = Model::Pinhole;
+            fx_ = info.p[0];
+            skew_ = 0.0;
+            cx_ = info.p[2];
+            tx_ = info.p[3];
+            fy_ = info.p[5];
+            cy_ = info.p[6];
+            ty_ = info.p[7];
+            return true;
+        }
+
+        model_ = Model::Equidistant;
+        fx_ = info.k[0];
+        skew_ = info.k[1];
+        cx_ = info.k[2];
+        fy_ = info.k[4];
+        cy_ = info.k[5];
+        tx_ = ty_ = 0.0;
+        buildRadiusTable(info.d[0], info.d[1], info.d[2], info.d[3]);
+        return true;
+    }
+
+    Model model() const { return model_; }
+
+    // True if the model was set up from this calibration, so a rebuild would change nothing
+    bool sameCalibration(const sensor_msgs::msg::CameraInfo& info, bool use_distortion = true) const
+    {
+        return initialized() && use_distortion == use_distortion_ && info.distortion_model == distortion_model_ &&
+               info.d == d_ && info.k == k_ && info.p == p_ && info.width == width_ && info.height == height_;
+    }
+
+    // Project a camera-frame point to pixel coordinates; false if it cannot be imaged
+    // (behind a pinhole camera, or beyond the field of view of the fisheye table)
+    bool project(double x, double y, double z, double& u, double& v) const
+    {
+        if (model_ == Model::Pinhole) {
+            if (z <= 0.0) return false;
+            u = (fx_ * x + skew_ * y + tx_) / z + cx_;
+            v = (fy_ * y + ty_) / z + cy_;
+            return true;
+        }
+        if (model_ == Model::DistortionMap) {
+            if (z <= 0.0) return false;
+            const double column = (x / z - map_x0_) * map_inverse_step_x_;
+            const double row = (y / z - map_y0_) * map_inverse_step_y_;
+            if (!(column >= 0.0 && row >= 0.0 && column < map_columns_ - 1 && row < map_rows_ - 1)) return false;
+            const size_t c = static_cast<size_t>(column);
+            const size_t r = static_cast<size_t>(row);
+            const double fc = column - c;
+            const double fr = row - r;
+            const float* top = &distortion_map_[2 * (r * map_columns_ + c)];
+            const float* bottom = top + 2 * map_columns_;
+            u = (1.0 - fr) * ((1.0 - fc) * top[0] + fc * top[2]) + fr * ((1.0 - fc) * bottom[0] + fc * bottom[2]);
+            v = (1.0 - fr) * ((1.0 - fc) * top[1] + fc * top[3]) + fr * ((1.0 - fc) * bottom[1] + fc * bottom[3]);
+            return !std::isnan(u);  // Cells touching a node beyond the extent are not imaged
+        }
+
+        // The table is indexed by q = tan(theta / 2) = |xy| / (|p| + z), which is close to
+        // linear in theta near the axis and needs no trigonometry
+        const double norm = std::sqrt(x * x + y * y + z * z);
+        const double denominator = norm + z;
+        if (denominator <= 0.0) return false;
+        const double position = std::sqrt(x * x + y * y) / denominator * inverse_step_;
+        if (position >= max_position_) return false;
+        const size_t index = static_cast<size_t>(position);
+        const double fraction = position - index;
+        const double ratio = radius_table_[index] + fraction * (radius_table_[index + 1] - radius_table_[index]);
+
+        // theta_d / |xy| == ratio / (|p| + z)
+        const double scale = ratio / denominator;
+        const double xd = x * scale;
+        const double yd = y * scale;
+        u = fx_ * xd + skew_ * yd + cx_;
+        v = fy_ * yd + cy_;
+        return true;
+    }
+
+private:
+    static constexpr size_t kTableSize = 1024;
+    static constexpr double kMaxTheta = 0.95 * 3.14159265358979323846;  // Beyond this the lens model is not meaningful
+    static constexpr double kMapPixelsPerCell = 2.0;  // Grid spacing of the distortion map in image pixels
+    static constexpr int kMapDirections = 64;  // Directions walked to find the extent of the distortion map
+
+    bool initialized() const { return fx_ != 0.0; }
+
+    double coefficient(size_t i) const { return i < d_.size() ? d_[i] : 0.0; }
+
+    // Radial factor and tangential offset of plumb_bob / rational_polynomial distortion
+    void distortionTerms(double x, double y, double& radial, double& dx, double& dy) const
+    {
+        const double r2 = x * x + y * y;
+        radial = (1.0 + r2 * (coefficient(0) + r2 * (coefficient(1) + r2 * coefficient(4)))) /
+                 (1.0 + r2 * (coefficient(5) + r2 * (coefficient(6) + r2 * coefficient(7))));
+        const double p1 = coefficient(2), p2 = coefficient(3);
+        dx = 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+        dy = p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+    }
+
+    // Sample the distortion on a grid over the normalized coordinates seen by the image. The
+    // extent is found by walking outwards from the optical axis in a fan of directions until
+    // the distorted point leaves the image by more than a margin, or the lens model folds
+    // back. The grid covers the bounding rectangle of the fan; its nodes beyond the extent of
+    // their direction are NaN, so points there, which the polynomial would fold back into
+    // the image, are not imaged.
+    void buildDistortionMap()
+    {
+        const double width = width_, height = height_;
+        const double margin = 0.05 * std::max(width, height);
+        const double direction_step = 2.0 * 3.14159265358979323846 / kMapDirections;
+        std::array<double, kMapDirections + 1> extent;  // Largest radius walked, per direction
+        double x_min = 0.0, x_max = 0.0, y_min = 0.0, y_max = 0.0;
+        for (int direction = 0; direction < kMapDirections; ++direction) {
+            const double angle = direction * direction_step;
+            const double cos_angle = std::cos(angle), sin_angle = std::sin(angle);
+            double previous_radius = 0.0;
+            extent[direction] = 0.0;
+            for (double r = 0.005; r < 10.0; r += 0.005) {
+                const double x = r * cos_angle, y = r * sin_angle;
+                double radial, dx, dy;
+                distortionTerms(x, y, radial, dx, dy);
+                const double xd = x * radial + dx, yd = y * radial + dy;
+                const double distorted_radius = std::sqrt(xd * xd + yd * yd);
+                if (distorted_radius <= previous_radius) break;
+                previous_radius = distorted_radius;
+                extent[direction] = r;
+                x_min = std::min(x_min, x);
+                x_max = std::max(x_max, x);
+                y_min = std::min(y_min, y);
+                y_max = std::max(y_max, y);
+                const double u = fx_ * xd + skew_ * yd + cx_, v = fy_ * yd + cy_;
+                if (u < -margin || u > width + margin || v < -margin || v > height + margin) break;
+            }
+        }
+        map_x0_ = x_min;
+        map_y0_ = y_min;
+        map_columns_ = static_cast<size_t>(std::ceil(1.1 * width / kMapPixelsPerCell)) + 2;
+        map_rows_ = static_cast<size_t>(std::ceil(1.1 * height / kMapPixelsPerCell)) + 2;
+        map_inverse_step_x_ = (map_columns_ - 1) / std::max(x_max - x_min, 1e-9);
+        map_inverse_step_y_ = (map_rows_ - 1) / std::max(y_max - y_min, 1e-9);
+
+        extent[kMapDirections] = extent[0];
+
+        distortion_map_.resize(2 * map_columns_ * map_rows_);
+        for (size_t r = 0; r < map_rows_; ++r) {
+            const double y = map_y0_ + r / map_inverse_step_y_;
+            for (size_t c = 0; c < map_columns_; ++c) {
+                const double x = map_x0_ + c / map_inverse_step_x_;
+
+                // Extent in the direction of the node, interpolated between the walked directions
+                double position = std::atan2(y, x) / direction_step;
+                if (position < 0.0) position += kMapDirections;
+                const int direction = std::min(static_cast<int>(position), kMapDirections - 1);
+                const double fraction = position - direction;
+                const double max_radius = (1.0 - fraction) * extent[direction] + fraction * extent[direction + 1];
+                if (x * x + y * y > max_radius * max_radius) {
+                    distortion_map_[2 * (r * map_columns_ + c)] = std::numeric_limits<float>::quiet_NaN();
+                    distortion_map_[2 * (r * map_columns_ + c) + 1] = std::numeric_limits<float>::quiet_NaN();
+                    continue;
+                }
+
+                double radial, dx, dy;
+                distortionTerms(x, y, radial, dx, dy);
+                const double xd = x * radial + dx;
+                const double yd = y * radial + dy;
+                distortion_map_[2 * (r * map_columns_ + c)] = static_cast<float>(fx_ * xd + skew_ * yd + cx_);
+                distortion_map_[2 * (r * map_columns_ + c) + 1] = static_cast<float>(fy_ * yd + cy_);
+            }
+        }
+    }
+
+    // Tabulate theta_d(theta) / q over q = tan(theta / 2), up to kMaxTheta or to where the
+    // calibrated polynomial stops increasing
+    void buildRadiusTable(double k1, double k2, double k3, double k4)
+    {
+        auto distorted = [&](double theta) {
+            const double theta2 = theta * theta;
+            return theta * (1.0 + theta2 * (k1 + theta2 * (k2 + theta2 * (k3 + theta2 * k4))));
+        };
+
+        double max_theta = kMaxTheta;
+        const double theta_step = kMaxTheta / kTableSize;
+        for (double theta = theta_step; theta <= kMaxTheta; theta += theta_step) {
+            if (distorted(theta) <= distorted(theta - theta_step)) {
+                max_theta = theta - theta_step;
+                break;
+            }
+        }
+
+        const double max_q = std::tan(0.5 * max_theta);
+        const double step = max_q / (kTableSize - 1);
+        inverse_step_ = 1.0 / step;
+        max_position_ = static_cast<double>(kTableSize - 1);
+        radius_table_.resize(kTableSize);
+        radius_table_[0] = 2.0;  // theta_d ~ theta ~ 2 q near the axis
+        for (size_t i = 1; i < kTableSize; ++i) {
+            const double q = i * step;
+            radius_table_[i] = distorted(2.0 * std::atan(q)) / q;
+        }
+    }
+
+    // Calibration the model was built from
+    std::string distortion_model_;
+    std::vector<double> d_;
+    std::array<double, 9> k_{};
+    std::array<double, 12> p_{};
+    uint32_t width_ = 0, height_ = 0;
+    bool use_distortion_ = true;
+
+    Model model_ = Model::Pinhole;
+    double fx_ = 0.0, fy_ = 0.0, cx_ = 0.0, cy_ = 0.0, skew_ = 0.0, tx_ = 0.0, ty_ = 0.0;
+    std::vector<double> radius_table_;  // theta_d / q at q = i * step
+    double inverse_step_ = 0.0, max_position_ = 0.0;
+    std::vector<float> distortion_map_;  // Interleaved (u, v) per grid node, row-major
+    size_t map_columns_ = 0, map_rows_ = 0;
+    double map_x0_ = 0.0, map_y0_ = 0.0, map_inverse_step_x_ = 0.0, map_inverse_step_y_ = 0.0;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__CAMERA_PROJECTION_HPP_
@@ -0,0 +1,76 @@
+#ifndef L2I_FUSION_DETECTION__DECIMATION_CONTROLLER_HPP_
+#define L2I_FUSION_DETECTION__DECIMATION_CONTROLLER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Chooses the input decimation stride that keeps the p99 processing time of the last
+// window frames under a budget. Processing cost is close to linear in the number of
+// points, so the stride is scaled by the measured overshoot, and lowered again once the
+// p99 predicted for the next denser stride fits the budget with some headroom. The
+// stride is read by the ingest stage while record() runs after publishing.
+class DecimationController
+{
+public:
+    DecimationController(double budget, size_t window, int max_stride)
+        : budget_(budget), max_stride_(std::max(max_stride, 1)),
+          samples_(std::max<size_t>(window, 1)), scratch_(samples_.size())
+    {
+    }
+
+    // Stride to apply to the next input cloud (1 keeps every point)
+    int stride() const { return stride_.load(std::memory_order_relaxed); }
+
+    // p99 of the processing times in the current window, in seconds
+    double percentile() const { return percentile_.load(std::memory_order_relaxed); }
+
+    // Record the processing time of one frame and adapt the stride once the window is full
+    void record(double seconds)
+    {
+        samples_[next_] = seconds;
+        next_ = (next_ + 1) % samples_.size();
+        if (filled_ < samples_.size()) filled_++;
+        if (filled_ < samples_.size()) return;
+
+        std::copy(samples_.begin(), samples_.end(), scratch_.begin());
+        const size_t rank = static_cast<size_t>(std::ceil(0.99 * scratch_.size())) - 1;
+        std::nth_element(scratch_.begin(), scratch_.begin() + rank, scratch_.end());
+        const double p99 = scratch_[rank];
+        percentile_.store(p99, std::memory_order_relaxed);
+
+        const int stride = stride_.load(std::memory_order_relaxed);
+        int next_stride = stride;
+        if (p99 > budget_ && stride < max_stride_) {
+            next_stride = std::max(stride + 1, static_cast<int>(std::ceil(stride * p99 / budget_)));
+        } else if (stride > 1 && p99 * stride / (stride - 1) < kRestoreHeadroom * budget_) {
+            next_stride = stride - 1;
+        }
+        next_stride = std::min(next_stride, max_stride_);
+
+        // Samples taken at the old stride say nothing about the new one
+        if (next_stride != stride) {
+            stride_.store(next_stride, std::memory_order_relaxed);
+            filled_ = 0;
+        }
+    }
+
+private:
+    static constexpr double kRestoreHeadroom = 0.9;  // Fraction of the budget a denser stride must fit in
+
+    double budget_;
+    int max_stride_;
+    std::vector<double> samples_, scratch_;
+    size_t next_ = 0, filled_ = 0;
+    std::atomic<int> stride_{1};
+    std::atomic<double> percentile_{0.0};
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__DECIMATION_CONTROLLER_HPP_
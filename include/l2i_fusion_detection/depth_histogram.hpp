@@ -0,0 +1,104 @@
+#ifndef L2I_FUSION_DETECTION__DEPTH_HISTOGRAM_HPP_
+#define L2I_FUSION_DETECTION__DEPTH_HISTOGRAM_HPP_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Fixed-width histogram over point depth (camera z axis). Each bin also keeps the
+// coordinate sums of its points, so the centroid of any run of bins is available
+// without a second pass over the points and without sorting.
+class DepthHistogram
+{
+public:
+    // Size the histogram to cover [0, max_depth]; deeper points land in the last bin
+    void reset(double bin_width, double max_depth)
+    {
+        inv_bin_width_ = 1.0 / bin_width;
+        const size_t num_bins = static_cast<size_t>(std::ceil(max_depth * inv_bin_width_)) + 1;
+        bins_.assign(num_bins, Bin());
+    }
+
+    // Add a point (camera frame, meters) to its depth bin
+    void add(double x, double y, double z)
+    {
+        if (bins_.empty() || z < 0.0) return;
+        const size_t index = std::min(static_cast<size_t>(z * inv_bin_width_), bins_.size() - 1);
+        Bin& bin = bins_[index];
+        bin.sum_x += x;
+        bin.sum_y += y;
+        bin.sum_z += z;
+        bin.count++;
+    }
+
+    // Centroid of the dominant foreground mode. The mode is the nearest local peak whose
+    // 3-bin window holds at least min_peak_ratio of the strongest window; it is grown
+    // over neighbouring bins while their counts keep falling off the peak.
+    bool modeCentroid(double min_peak_ratio, Eigen::Vector3d& centroid) const
+    {
+        const size_t num_bins = bins_.size();
+        int max_window = 0;
+        for (size_t i = 0; i < num_bins; ++i) {
+            max_window = std::max(max_window, window(i));
+        }
+        if (max_window == 0) return false;
+
+        // Nearest bin that is a local peak of the smoothed histogram and strong enough
+        const double threshold = min_peak_ratio * max_window;
+        size_t peak = num_bins;
+        for (size_t i = 0; i < num_bins; ++i) {
+            const int w = window(i);
+            if (w >= threshold && (i + 1 == num_bins || w >= window(i + 1)) && bins_[i].count > 0) {
+                peak = i;
+                break;
+            }
+        }
+        if (peak == num_bins) {
+            // Fall back to the most populated bin
+            peak = 0;
+            for (size_t i = 1; i < num_bins; ++i) {
+                if (bins_[i].count > bins_[peak].count) peak = i;
+            }
+        }
+
+        // Grow the mode while neighbouring bins are non-empty and descending
+        size_t first = peak, last = peak;
+        while (first > 0 && bins_[first - 1].count > 0 && bins_[first - 1].count <= bins_[first].count) --first;
+        while (last + 1 < num_bins && bins_[last + 1].count > 0 && bins_[last + 1].count <= bins_[last].count) ++last;
+
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        int count = 0;
+        for (size_t i = first; i <= last; ++i) {
+            sum += Eigen::Vector3d(bins_[i].sum_x, bins_[i].sum_y, bins_[i].sum_z);
+            count += bins_[i].count;
+        }
+        centroid = sum / count;
+        return true;
+    }
+
+private:
+    struct Bin {
+        double sum_x = 0, sum_y = 0, sum_z = 0;  // Accumulated point coordinates in this bin
+        int count = 0;  // Number of points in this bin
+    };
+
+    // Count of a bin and its two neighbours, used to find peaks robustly
+    int window(size_t i) const
+    {
+        int w = bins_[i].count;
+        if (i > 0) w += bins_[i - 1].count;
+        if (i + 1 < bins_.size()) w += bins_[i + 1].count;
+        return w;
+    }
+
+    std::vector<Bin> bins_;
+    double inv_bin_width_ = 1.0;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__DEPTH_HISTOGRAM_HPP_
@@ -0,0 +1,203 @@
+#ifndef L2I_FUSION_DETECTION__GROUND_SEGMENTATION_HPP_
+#define L2I_FUSION_DETECTION__GROUND_SEGMENTATION_HPP_
+
+#include <pcl/point_cloud.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Shortest horizontal step (meters) along which the ground of an organized column moves on;
+// returns stacked closer than this lie on a vertical surface
+constexpr double kMinGroundRun = 0.02;
+
+// Ground removal in the lidar frame (z up), run before cropping and transforming.
+// Organized clouds use a per-column slope test across rings; unorganized clouds
+// fit a near-horizontal plane to a sample of the points.
+class GroundSegmentation
+{
+public:
+    GroundSegmentation(double max_slope_deg, double distance_threshold, int ransac_iterations, size_t max_samples)
+        : max_slope_(std::tan(max_slope_deg * M_PI / 180.0)),
+          min_normal_z_(std::cos(max_slope_deg * M_PI / 180.0)),
+          distance_threshold_(distance_threshold),
+          ransac_iterations_(ransac_iterations),
+          max_samples_(max_samples)
+    {
+    }
+
+    // Allocate storage up front for clouds of up to max_points points
+    void reserve(size_t max_points)
+    {
+        is_ground_.reserve(max_points);
+        heights_.reserve(max_points);
+        samples_.reserve(max_samples_);
+    }
+
+    // Remove ground points in place; the result is an unorganized cloud
+    template <typename PointT>
+    void removeGround(pcl::PointCloud<PointT>& cloud)
+    {
+        is_ground_.assign(cloud.points.size(), 0);
+        if (cloud.height > 1 && cloud.width > 0) {
+            labelOrganized(cloud);
+        } else {
+            labelUnorganized(cloud);
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < cloud.points.size(); ++i) {
+            if (!is_ground_[i]) cloud.points[kept++] = cloud.points[i];
+        }
+        cloud.points.resize(kept);
+        cloud.width = static_cast<uint32_t>(kept);
+        cloud.height = 1;
+    }
+
+private:
+    template <typename PointT>
+    static bool isValid(const PointT& p)
+    {
+        return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z);
+    }
+
+    // Walk each column from the lowest ring upwards. The ground under the sensor is taken as
+    // the median height of the columns' lowest returns below it; a column starts on the ground
+    // at its lowest return if that return is within the slope limit of this point, seen from
+    // below the sensor origin. Later returns are ground while they are within the distance
+    // threshold of the last ground return, and the last ground return only moves on along a
+    // step with a real horizontal run and a slope below the limit. A vertical obstacle, whose
+    // returns are stacked at one range, therefore cannot pull the ground up with it.
+    template <typename PointT>
+    void labelOrganized(const pcl::PointCloud<PointT>& cloud)
+    {
+        const size_t rows = cloud.height, cols = cloud.width;
+
+        // Ring order differs between drivers: find out whether row 0 is the lowest ring
+        double first_row_z = 0, last_row_z = 0;
+        for (size_t c = 0; c < cols; ++c) {
+            const PointT& first = cloud.points[c];
+            const PointT& last = cloud.points[(rows - 1) * cols + c];
+            if (isValid(first)) first_row_z += first.z / std::max(1e-3f, std::hypot(first.x, first.y));
+            if (isValid(last)) last_row_z += last.z / std::max(1e-3f, std::hypot(last.x, last.y));
+        }
+        const bool bottom_up = first_row_z <= last_row_z;
+        auto lowest_return = [&](size_t c) -> const PointT* {
+            for (size_t k = 0; k < rows; ++k) {
+                const PointT& p = cloud.points[(bottom_up ? k : rows - 1 - k) * cols + c];
+                if (isValid(p)) return &p;
+            }
+            return nullptr;
+        };
+
+        // Height of the ground under the sensor, from the columns whose lowest return is below it
+        heights_.clear();
+        for (size_t c = 0; c < cols; ++c) {
+            const PointT* p = lowest_return(c);
+            if (p && p->z < 0.0f) heights_.push_back(p->z);
+        }
+        if (heights_.empty()) return;
+        std::nth_element(heights_.begin(), heights_.begin() + heights_.size() / 2, heights_.end());
+        const double sensor_ground_z = heights_[heights_.size() / 2];
+
+        for (size_t c = 0; c < cols; ++c) {
+            const PointT* ground = nullptr;
+            for (size_t k = 0; k < rows; ++k) {
+                const size_t index = (bottom_up ? k : rows - 1 - k) * cols + c;
+                const PointT& p = cloud.points[index];
+                if (!isValid(p)) continue;
+
+                if (ground == nullptr) {
+                    // The lowest return of the column, against the ground below the sensor
+                    const double range = std::hypot(p.x, p.y);
+                    if (std::abs(p.z - sensor_ground_z) > distance_threshold_ + max_slope_ * range) break;
+                    is_ground_[index] = 1;
+                    ground = &p;
+                    continue;
+                }
+
+                const double run = std::hypot(p.x - ground->x, p.y - ground->y);
+                const double rise = std::abs(p.z - ground->z);
+                if (run > kMinGroundRun && rise <= max_slope_ * run) {
+                    is_ground_[index] = 1;
+                    ground = &p;  // Ground continues along the slope
+                } else if (rise <= distance_threshold_) {
+                    is_ground_[index] = 1;  // Close to the last ground return, which stays the reference
+                }
+            }
+        }
+    }
+
+    // Fit a plane with a normal within the slope limit of vertical to a strided sample of
+    // the points below the sensor, then label every point within the distance threshold.
+    template <typename PointT>
+    void labelUnorganized(const pcl::PointCloud<PointT>& cloud)
+    {
+        samples_.clear();
+        const size_t stride = std::max<size_t>(1, cloud.points.size() / max_samples_);
+        for (size_t i = 0; i < cloud.points.size(); i += stride) {
+            const PointT& p = cloud.points[i];
+            if (isValid(p) && p.z < 0.0f) samples_.emplace_back(p.x, p.y, p.z);
+        }
+        if (samples_.size() < 3) return;
+
+        // Deterministic pseudo-random sampling keeps results reproducible between runs
+        uint32_t seed = 0x9e3779b9u;
+        auto next_index = [&]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<size_t>(seed >> 8) % samples_.size();
+        };
+
+        Eigen::Vector3f best_normal = Eigen::Vector3f::Zero();
+        float best_d = 0.0f;
+        size_t best_inliers = 0;
+        for (int iteration = 0; iteration < ransac_iterations_; ++iteration) {
+            const Eigen::Vector3f& a = samples_[next_index()];
+            const Eigen::Vector3f& b = samples_[next_index()];
+            const Eigen::Vector3f& c = samples_[next_index()];
+            Eigen::Vector3f normal = (b - a).cross(c - a);
+            const float norm = normal.norm();
+            if (norm < 1e-6f) continue;
+            normal /= norm;
+            if (normal.z() < 0.0f) normal = -normal;
+            if (normal.z() < min_normal_z_) continue;  // Too steep to be ground
+
+            const float d = -normal.dot(a);
+            size_t inliers = 0;
+            for (const auto& s : samples_) {
+                if (std::abs(normal.dot(s) + d) <= distance_threshold_) inliers++;
+            }
+            if (inliers > best_inliers) {
+                best_inliers = inliers;
+                best_normal = normal;
+                best_d = d;
+            }
+        }
+        if (best_inliers == 0) return;
+
+        for (size_t i = 0; i < cloud.points.size(); ++i) {
+            const PointT& p = cloud.points[i];
+            if (!isValid(p)) continue;
+            const float distance = best_normal.x() * p.x + best_normal.y() * p.y + best_normal.z() * p.z + best_d;
+            if (std::abs(distance) <= distance_threshold_) is_ground_[i] = 1;
+        }
+    }
+
+    double max_slope_;  // Tangent of the maximum ground slope
+    double min_normal_z_;  // Cosine of the maximum ground slope
+    double distance_threshold_;  // Maximum height of a ground point above its neighbour or plane (meters)
+    int ransac_iterations_;
+    size_t max_samples_;
+    std::vector<uint8_t> is_ground_;
+    std::vector<float> heights_;  // Lowest return height of each column
+    std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> samples_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__GROUND_SEGMENTATION_HPP_
@@ -0,0 +1,77 @@
+#ifndef L2I_FUSION_DETECTION__INSTANCE_MASK_HPP_
+#define L2I_FUSION_DETECTION__INSTANCE_MASK_HPP_
+
+#include <yolo_msgs/msg/mask.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Instance mask rasterized once per frame into a byte bitmap covering only the
+// detection's bounding box, so testing a projected point is a single lookup.
+class InstanceMask
+{
+public:
+    // Rasterize the mask polygon inside the pixel window [x_min, x_max] x [y_min, y_max]
+    void decode(const yolo_msgs::msg::Mask& mask, double x_min, double y_min, double x_max, double y_max)
+    {
+        x0_ = static_cast<int>(std::floor(x_min));
+        y0_ = static_cast<int>(std::floor(y_min));
+        width_ = std::max(0, static_cast<int>(std::ceil(x_max)) - x0_ + 1);
+        height_ = std::max(0, static_cast<int>(std::ceil(y_max)) - y0_ + 1);
+        bits_.assign(static_cast<size_t>(width_) * height_, 0);
+        if (mask.data.size() < 3 || bits_.empty()) {
+            bits_.clear();
+            return;
+        }
+
+        // Even-odd scanline fill sampled at pixel centers; the crossing buffer is reused
+        // between frames so decoding does not allocate once it has grown
+        const auto& vertices = mask.data;
+        const size_t num_vertices = vertices.size();
+        for (int row = 0; row < height_; ++row) {
+            const double y = y0_ + row + 0.5;
+            crossings_.clear();
+            for (size_t i = 0, j = num_vertices - 1; i < num_vertices; j = i++) {
+                const auto& a = vertices[i];
+                const auto& b = vertices[j];
+                if ((a.y <= y) != (b.y <= y)) {
+                    crossings_.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+                }
+            }
+            std::sort(crossings_.begin(), crossings_.end());
+
+            uint8_t* bitmap_row = bits_.data() + static_cast<size_t>(row) * width_;
+            for (size_t k = 0; k + 1 < crossings_.size(); k += 2) {
+                const int first = std::max(0, static_cast<int>(std::ceil(crossings_[k] - 0.5)) - x0_);
+                const int last = std::min(width_ - 1, static_cast<int>(std::floor(crossings_[k + 1] - 0.5)) - x0_);
+                for (int x = first; x <= last; ++x) bitmap_row[x] = 1;
+            }
+        }
+    }
+
+    // True when no polygon was decoded, the bounding box is then used alone
+    bool empty() const { return bits_.empty(); }
+
+    // Test a pixel that already passed the bounding box check
+    bool contains(double u, double v) const
+    {
+        const int x = static_cast<int>(std::floor(u)) - x0_;
+        const int y = static_cast<int>(std::floor(v)) - y0_;
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) return false;
+        return bits_[static_cast<size_t>(y) * width_ + x] != 0;
+    }
+
+private:
+    int x0_ = 0, y0_ = 0;  // Bitmap origin in image space
+    int width_ = 0, height_ = 0;  // Bitmap size in pixels
+    std::vector<uint8_t> bits_;  // One byte per pixel, non-zero inside the mask
+    std::vector<double> crossings_;  // Polygon edge crossings of the current scanline
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__INSTANCE_MASK_HPP_
@@ -0,0 +1,452 @@
+#ifndef L2I_FUSION_DETECTION__LIDAR_CAMERA_FUSION_NODE_HPP_
+#define L2I_FUSION_DETECTION__LIDAR_CAMERA_FUSION_NODE_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <yolo_msgs/msg/detection_array.hpp>
+#include <geometry_msgs/msg/pose_array.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+#include <opencv2/opencv.hpp>
+#include <Eigen/Geometry>
+#include <message_filters/subscriber.h>
+#include <message_filters/synchronizer.h>
+#include <message_filters/sync_policies/approximate_time.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "l2i_fusion_detection/allocation_counter.hpp"
+#include "l2i_fusion_detection/bounded_queue.hpp"
+#include "l2i_fusion_detection/camera_projection.hpp"
+#include "l2i_fusion_detection/decimation_controller.hpp"
+#include "l2i_fusion_detection/depth_histogram.hpp"
+#include "l2i_fusion_detection/ground_segmentation.hpp"
+#include "l2i_fusion_detection/instance_mask.hpp"
+#include "l2i_fusion_detection/point_cloud2_reader.hpp"
+#include "l2i_fusion_detection/point_cloud2_writer.hpp"
+#include "l2i_fusion_detection/realtime_sync.hpp"
+#include "l2i_fusion_detection/voxel_clustering.hpp"
+#include "l2i_fusion_detection/voxel_downsampling.hpp"
+#include "l2i_fusion_detection/worker_pool.hpp"
+
+namespace l2i_fusion_detection
+{
+
+// Fuses lidar points with camera detections: projects the cropped clouds of all configured
+// lidars into the image of every configured camera in one pass, associates points with each
+// camera's detections and publishes object poses and clouds per camera. Built as a component so it can share a
+// process (and intra-process zero-copy transport) with its consumers.
+class LidarCameraFusionNode : public rclcpp::Node
+{
+public:
+    explicit LidarCameraFusionNode(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
+    ~LidarCameraFusionNode() override;
+
+    // Executor the standalone node is spun with; a component container brings its own
+    bool useMultiThreadedExecutor() const { return executor_ == "multi_threaded"; }
+    size_t executorThreads() const { return static_cast<size_t>(executor_threads_); }
+
+private:
+    friend class SteadyStateAllocationTest;  // Drives processFrame with synthetic frames
+
+    // Structure to hold bounding box information
+    struct BoundingBox {
+        double x_min, y_min, x_max, y_max;  // Bounding box coordinates in image space
+        double sum_x = 0, sum_y = 0, sum_z = 0;  // Accumulated point coordinates for averaging
+        int count = 0;  // Number of points in the bounding box
+        bool valid = false;  // Flag to indicate if the bounding box is valid
+        int id = -1;  // ID of the detected object
+        int class_id = -1;  // Class of the detected object
+        pcl::PointCloud<pcl::PointXYZ>::Ptr object_cloud = nullptr;  // Point cloud for the object
+        DepthHistogram depth_histogram;  // Depth histogram for robust pose estimation
+        InstanceMask mask;  // Instance mask inside the bounding box (mask association only)
+    };
+
+    // Point associated with a detection during the parallel projection, applied to its box
+    // once all threads are done
+    struct Association {
+        uint32_t camera, box;  // Indexes into the frame's cameras and that camera's boxes
+        float x, y, z;  // Point in the camera frame
+        double u, v;  // Projected pixel
+    };
+
+    // Affine transform stored without alignment requirements, so it can live in any container
+    using UnalignedAffine3d = Eigen::Transform<double, 3, Eigen::Affine, Eigen::DontAlign>;
+    using UnalignedAffine3f = Eigen::Transform<float, 3, Eigen::Affine, Eigen::DontAlign>;
+
+    // Transform with the stamp of the TF data it was looked up from
+    struct StampedTransform {
+        double stamp = 0.0;  // Seconds; 0 for a static transform
+        UnalignedAffine3d transform = UnalignedAffine3d::Identity();
+    };
+
+    // Lidar/camera extrinsics of one camera from one refresh, cached for real-time mode
+    struct Extrinsics {
+        std::vector<StampedTransform> lidar_to_camera;  // One per lidar
+        StampedTransform camera_to_lidar;  // Into the pose frame (lidar_frame)
+    };
+
+    // Recent extrinsics of one camera, oldest first, so that a moving camera (e.g. on a
+    // gimbal) is placed at the stamp of each cloud; replaced as a whole, never modified
+    using ExtrinsicsHistory = std::vector<Extrinsics>;
+
+    // One lidar of the rig. The first lidar is synchronized with the first camera and
+    // triggers processing; the scans of the others are matched to it by stamp.
+    struct Lidar {
+        std::string name;  // Parameter prefix, empty for the single-lidar setup
+        std::string lidar_frame;  // Frame the real-time mode extrinsics are looked up from
+        std::string topic;
+        PointCloud2Reader point_cloud_reader;  // Decoder selected for the stream's point layout
+
+        // Secondary lidars: recent scans, kept in a small ring until a frame picks the one
+        // closest to its stamp
+        rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr point_cloud_sub;
+        PriorityInheritanceMutex scans_mutex;  // Also taken by the real-time thread
+        std::vector<sensor_msgs::msg::PointCloud2::ConstSharedPtr> recent_scans;
+        size_t next_scan = 0;
+    };
+
+    // Intrinsics of one camera calibration with the tables derived from it. Never modified
+    // once published: a changed CameraInfo builds a new snapshot, so a frame projects with
+    // the one it loaded while the next calibration is being set up.
+    struct Calibration {
+        CameraProjection projection;  // Model chosen from CameraInfo.distortion_model
+        int image_width = 0, image_height = 0;
+    };
+
+    // One camera of the rig: frame, intrinsics, inputs and outputs. The first camera is
+    // synchronized with the lidar; the others are matched to each scan by stamp.
+    struct Camera {
+        std::string name;  // Parameter and topic prefix, empty for the single-camera setup
+        std::string camera_frame;
+        std::string image_topic, camera_info_topic, detection_topic;
+        std::string fused_image_topic, pose_topic, object_cloud_topic;
+
+        // Current calibration, null until the first CameraInfo
+        SnapshotHolder<Calibration> calibration;
+        rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_sub;
+
+        // Real-time mode extrinsics cache, null until the first refresh
+        SnapshotHolder<ExtrinsicsHistory> extrinsics;
+
+        // Secondary cameras: image/detection pairs synchronized with each other and kept
+        // in a small ring until a scan picks the one closest to its stamp
+        message_filters::Subscriber<sensor_msgs::msg::Image> image_sub;
+        message_filters::Subscriber<yolo_msgs::msg::DetectionArray> detection_sub;
+        std::shared_ptr<message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<
+            sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>>> pair_sync;
+        PriorityInheritanceMutex pairs_mutex;  // Also taken by the real-time thread
+        std::vector<std::pair<sensor_msgs::msg::Image::ConstSharedPtr, yolo_msgs::msg::DetectionArray::ConstSharedPtr>> recent_pairs;
+        size_t next_pair = 0;
+
+        // Publishers for fused image, object poses, and object point clouds
+        rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr image_publisher;
+        rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr pose_publisher;
+        rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr object_point_cloud_publisher;
+    };
+
+    // Per-camera part of a frame: inputs, transform and the retained detection buffers
+    struct CameraFrame {
+        sensor_msgs::msg::Image::ConstSharedPtr image_msg;  // Null if no image matched the scan
+        yolo_msgs::msg::DetectionArray::ConstSharedPtr detection_msg;
+        std::shared_ptr<const Calibration> calibration;  // Loaded once per frame
+        std::vector<BoundingBox> bounding_boxes;  // Detections of the current frame
+        std::vector<BoundingBox> spare_boxes;  // Boxes of earlier frames, ready for reuse
+        std::vector<cv::Point2d> projected_points;  // Associated points in image space
+        std::vector<geometry_msgs::msg::Pose> poses;  // Object poses in the lidar frame
+    };
+
+    // Per-lidar part of a frame: the scan, cropped in its own frame, and its transforms
+    struct LidarFrame {
+        sensor_msgs::msg::PointCloud2::ConstSharedPtr point_cloud_msg;  // Null if no scan matched the frame
+        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud{new pcl::PointCloud<pcl::PointXYZ>};  // Cropped cloud in the lidar frame
+        std::vector<UnalignedAffine3f> to_camera;  // Applied to each point before projection, one per camera
+    };
+
+    // Buffers for one frame, retained between frames: they are cleared rather than freed, so
+    // once they have grown to the largest scan and detection count seen, a frame allocates
+    // nothing on the processing path. Boxes are recycled through spare_boxes together with
+    // their object clouds, histograms and mask bitmaps.
+    struct FrameWorkspace {
+        std::vector<LidarFrame> lidars;  // One entry per configured lidar; the first scan stamps the frame
+        std::vector<CameraFrame> cameras;  // One entry per configured camera
+        std::vector<size_t> lidar_offsets;  // Index of each lidar's first point in the merged scan
+
+        // Results handed from one pipeline stage to the next
+        bool skipped = false;  // Set by ingest when the frame is not processed further
+        bool poses_only = false;  // Set by ingest for late frames that only get poses published
+        uint64_t allocations = 0;  // Fusion-path allocations made for this frame
+        double processing_time = 0.0;  // Time spent in the fusion stages (seconds)
+        uint32_t decimation_stride = 1;  // Column stride applied when decoding the cloud
+    };
+
+    // One stage of the frame pipeline, run on a FrameWorkspace
+    using FrameStage = void (LidarCameraFusionNode::*)(FrameWorkspace&);
+
+    // Declare and load parameters from the parameter server
+    void declare_parameters();
+
+    // Initialize subscribers and publishers
+    void initialize_subscribers_and_publishers();
+
+    // Read the camera list and the per-camera topics and frames
+    void declare_cameras();
+
+    // Read the lidar list and the per-lidar topics and frames
+    void declare_lidars();
+
+    // Callback for camera info to initialize the camera model
+    void camera_info_callback(const sensor_msgs::msg::CameraInfo::SharedPtr msg, Camera& camera);
+
+    // Keep a synchronized image/detection pair of a secondary camera for matching with scans
+    void camera_pair_callback(const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                              const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg,
+                              Camera& camera);
+
+    // Keep a scan of a secondary lidar for matching with frames
+    void lidar_scan_callback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg, Lidar& lidar);
+
+    // Synchronized callback for point cloud, image, and detections
+    void sync_callback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                       const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                       const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg);
+
+    // Run the fusion pipeline on one synchronized frame
+    void processFrame(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                      const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                      const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg);
+
+    // Attach the synchronized inputs, the closest scan of every secondary lidar and the
+    // closest pair of every secondary camera to a frame
+    void assignFrameInputs(FrameWorkspace& workspace,
+                           const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                           const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                           const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg);
+
+    // Pipeline stages; processFrame runs them in order, pipelined mode on one thread each
+    void ingestFrame(FrameWorkspace& workspace);  // Decode and crop scans, resolve transforms, read detections
+    void associateFrame(FrameWorkspace& workspace);  // Project and associate with detections
+    void estimateFramePoses(FrameWorkspace& workspace);  // Cluster, compute poses, downsample
+    void publishFrame(FrameWorkspace& workspace);  // Serialize and publish, release the inputs
+
+    // Run a fusion stage and add the allocations it made and its duration to the frame
+    void runFusionStage(FrameStage stage, FrameWorkspace& workspace);
+
+    // Start one thread per pipeline stage, connected by bounded queues (only the publish stage
+    // in non-pipelined real-time mode)
+    void startPipeline();
+
+    // Pipeline stage thread: run stage on each frame from input and pass it to output
+    void pipelineStageLoop(FrameStage stage, bool fusion_stage,
+                           BoundedQueue<FrameWorkspace*>& input, BoundedQueue<FrameWorkspace*>& output);
+
+    // Reserve every per-frame buffer for max_points points and max_boxes detections
+    void preallocateWorkspaces();
+
+    // Lock memory, then start the SCHED_FIFO processing thread and reschedule the workers
+    void startRealtimeThread();
+
+    // Give a thread the configured real-time priority and CPU affinity
+    bool applyRealtimeScheduling(std::thread& thread);
+
+    // Real-time processing thread: runs the latest frame handed over by sync_callback
+    void realtimeLoop();
+
+    // Refresh the cached extrinsics from TF without waiting (timer, off the hot path)
+    void refreshExtrinsics();
+
+    // Transform at stamp from an extrinsics history, select picking it from each entry:
+    // interpolated between the entries around stamp, the newest one past the history
+    template <typename Select>
+    static UnalignedAffine3d extrinsicsAt(const ExtrinsicsHistory& history, double stamp, Select select);
+
+    // Process point cloud: decode and crop in the lidar frame
+    void processPointCloud(Lidar& lidar, const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg, uint32_t decimation_stride,
+                           pcl::PointCloud<pcl::PointXYZ>& cloud);
+
+    // Resolve the transform from a lidar's cloud frame to a camera frame at the cloud stamp
+    void resolveCameraTransform(const Camera& camera, size_t lidar_index, const std_msgs::msg::Header& cloud_header,
+                                UnalignedAffine3f& lidar_to_camera);
+
+    // Process detections: extract bounding boxes from YOLO detections
+    void processDetections(const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg, CameraFrame& camera_frame);
+
+    // Project the 3D points of every lidar to 2D image space of every camera and associate
+    // with bounding boxes
+    void projectPointsAndAssociateWithBoundingBoxes(FrameWorkspace& workspace);
+
+    // Keep only the selected voxel cluster of each object cloud, in parallel across boxes
+    void clusterObjectClouds(std::vector<BoundingBox>& bounding_boxes);
+
+    // Replace each object cloud by its voxel centroids, in parallel across boxes
+    void downsampleObjectClouds(std::vector<BoundingBox>& bounding_boxes);
+
+    // Calculate object poses in the lidar frame
+    void calculateObjectPoses(
+        const Camera& camera,
+        const std::vector<BoundingBox>& bounding_boxes,
+        const rclcpp::Time& cloud_time,
+        std::vector<geometry_msgs::msg::Pose>& poses);
+
+    // Publish results: fused image, object poses, and object point clouds. Messages are
+    // borrowed from the middleware when it supports loans for their type (none of these on
+    // Humble, whose RMWs only loan fixed-size types); otherwise they are published as
+    // unique_ptr so intra-process subscribers receive them without a copy.
+    void publishResults(const Camera& camera, const CameraFrame& camera_frame, const rclcpp::Time& cloud_time);
+
+    // Publish the object poses of a frame in the lidar frame
+    void publishPoses(const Camera& camera, const std::vector<geometry_msgs::msg::Pose>& poses, const rclcpp::Time& cloud_time);
+
+    // Publish all object points of the frame in one cloud, labeled with the detection ID
+    // (and optionally the class ID) of the object they belong to
+    void publishBatchedObjectClouds(
+        const Camera& camera,
+        const std::vector<BoundingBox>& bounding_boxes,
+        const std_msgs::msg::Header& header);
+
+    // Count the frame and check its processing-path allocations once past the warm-up frames
+    void recordFrameMetrics(uint64_t frame_allocations, uint64_t publish_allocations);
+
+    // Publish the frame and allocation metrics as diagnostics
+    void publishMetrics();
+
+    // TF2 buffer and listener for coordinate transformations
+    tf2_ros::Buffer tf_buffer_;
+    tf2_ros::TransformListener tf_listener_;
+
+    // Frame workspaces, alternated per frame (two, or one per frame in flight when pipelined)
+    std::vector<FrameWorkspace> frame_workspaces_;
+    size_t frame_index_ = 0;
+
+    // Publishing mode for large outputs
+    bool use_intra_process_comms_;
+    bool use_loaned_messages_;
+
+    // Cameras projected into (the first one is synchronized with the lidar)
+    std::vector<std::unique_ptr<Camera>> cameras_;
+    double camera_sync_tolerance_;
+    bool use_distortion_;  // Project plumb_bob / rational_polynomial cameras into the raw image
+
+    // Lidars merged into each frame (the first one is synchronized with the primary camera)
+    std::vector<std::unique_ptr<Lidar>> lidars_;
+    double lidar_sync_tolerance_;
+
+    // Parameters for cropping and coordinate frames
+    float min_range_, max_range_;
+    std::string camera_frame_, lidar_frame_;
+
+    // Parameters for depth histogram based pose estimation
+    bool use_depth_histogram_;
+    float depth_histogram_bin_width_, depth_histogram_peak_ratio_;
+
+    // Association of projected points with detections: "bbox" or "mask"
+    std::string association_mode_;
+    bool use_mask_association_;
+
+    // Parameters and per-thread workspaces for voxel clustering inside each detection
+    bool use_clustering_;
+    float cluster_tolerance_;
+    int cluster_min_points_;
+    std::string cluster_selection_;
+    size_t num_threads_;
+    std::shared_ptr<WorkerPool> worker_pool_;  // Threads shared by all parallel stages (and nodes)
+    std::vector<VoxelClustering> cluster_workspaces_;
+    std::vector<std::vector<int>> cluster_indices_;
+
+    // Associations found in each slice of the merged scan, one slice per worker thread; only
+    // one frame is projected at a time, so they are shared by the frame workspaces
+    std::vector<std::vector<Association>> association_slices_;
+
+    // Optional ground removal applied to the raw cloud
+    std::unique_ptr<GroundSegmentation> ground_segmentation_;
+
+    // Voxel size for published object clouds and per-thread downsampling workspaces
+    float object_cloud_leaf_size_;
+    std::vector<VoxelDownsampling> downsampling_workspaces_;
+
+    // Publish one labeled object cloud per frame instead of one message per object
+    bool batch_object_clouds_, publish_class_id_;
+
+    // Field layouts for per-object and batched object clouds, written without a PCL round trip
+    PointCloud2Writer object_cloud_writer_;
+    PointCloud2Writer batched_cloud_writer_;
+
+    // Real-time mode: preallocated maximums, scheduling of the processing thread and cached extrinsics
+    bool realtime_;
+    int realtime_priority_;
+    std::vector<int64_t> realtime_cpus_;
+    size_t max_points_, max_boxes_, max_object_points_;
+    double transform_refresh_period_;
+    rclcpp::TimerBase::SharedPtr extrinsics_timer_;
+
+    // Hand-over of the latest synchronized frame to the real-time thread
+    std::thread realtime_thread_;
+    PriorityInheritanceMutex realtime_mutex_;  // Guards the pending frame
+    Semaphore realtime_wakeup_;  // Posted when a frame becomes pending, and on shutdown
+    std::atomic<bool> realtime_stop_{false};
+    sensor_msgs::msg::PointCloud2::ConstSharedPtr pending_point_cloud_;
+    sensor_msgs::msg::Image::ConstSharedPtr pending_image_;
+    yolo_msgs::msg::DetectionArray::ConstSharedPtr pending_detections_;
+    std::atomic<uint64_t> superseded_frames_{0}, oversized_frames_{0};
+
+    // Frames older than the latency budget when processing starts are dropped or reduced to poses
+    double latency_budget_;
+    std::string late_frame_policy_;
+    std::atomic<uint64_t> late_dropped_frames_{0}, late_pose_only_frames_{0};
+
+    // Adaptive input decimation holding the p99 processing time under a budget
+    bool adaptive_decimation_;
+    std::unique_ptr<DecimationController> decimation_controller_;
+
+    // Pipelined mode: stage queues (stage_queues_[i] feeds stage i) and the free workspaces;
+    // real-time mode uses them for the publish stage alone. pipeline_full_frames_ counts the
+    // frames dropped because every workspace was in flight.
+    bool pipeline_;
+    int pipeline_depth_;
+    std::unique_ptr<BoundedQueue<FrameWorkspace*>> free_workspaces_;
+    std::array<std::unique_ptr<BoundedQueue<FrameWorkspace*>>, 4> stage_queues_;
+    std::vector<std::thread> pipeline_threads_;
+    std::atomic<uint64_t> pipeline_full_frames_{0};
+
+    // Metrics exported on /diagnostics; allocation counts are per frame, from tracked threads only
+    double metrics_period_;
+    int allocation_check_warmup_frames_;
+    bool fail_on_steady_state_allocation_;
+    std::atomic<uint64_t> frames_processed_{0};
+    std::atomic<uint64_t> last_frame_allocations_{0}, last_publish_allocations_{0};
+    std::atomic<uint64_t> allocating_frames_{0}, max_steady_state_allocations_{0};
+    std::atomic<uint64_t> failed_allocation_frame_{0};  // First allocating frame with fail_on_steady_state_allocation, latched
+    rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr metrics_publisher_;
+    rclcpp::TimerBase::SharedPtr metrics_timer_;
+
+    // Callback groups, so that on a multi-threaded executor the synchronized inputs, the
+    // buffered inputs of secondary cameras and lidars, camera_info and the timers never wait
+    // on each other
+    std::string executor_;
+    int executor_threads_;
+    rclcpp::CallbackGroup::SharedPtr sync_callback_group_, buffer_callback_group_;
+    rclcpp::CallbackGroup::SharedPtr camera_info_callback_group_, timer_callback_group_;
+
+    // Subscribers for the primary lidar's point cloud, and image and detections of the primary camera
+    message_filters::Subscriber<sensor_msgs::msg::PointCloud2> point_cloud_sub_;
+    message_filters::Subscriber<sensor_msgs::msg::Image> image_sub_;
+    message_filters::Subscriber<yolo_msgs::msg::DetectionArray> detection_sub_;
+
+    // Synchronizer for aligning messages
+    std::shared_ptr<message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<sensor_msgs::msg::PointCloud2, sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>>> sync_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__LIDAR_CAMERA_FUSION_NODE_HPP_
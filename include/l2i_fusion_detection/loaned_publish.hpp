@@ -0,0 +1,33 @@
+#ifndef L2I_FUSION_DETECTION__LOANED_PUBLISH_HPP_
+#define L2I_FUSION_DETECTION__LOANED_PUBLISH_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <memory>
+#include <utility>
+
+namespace l2i_fusion_detection
+{
+
+// Publish a message written in place by fill(MessageT&). When loans are allowed and the
+// RMW can loan this message type, the message is borrowed from the middleware (e.g. a
+// shared-memory segment) so it is never copied after being written. Otherwise it is
+// allocated here and handed over as unique_ptr, which keeps intra-process delivery zero-copy.
+// RMWs only loan fixed-size types, so messages with unbounded arrays (Image, PointCloud2)
+// always take the second path on Humble.
+template <typename MessageT, typename FillT>
+void publishLoanedOrOwned(rclcpp::Publisher<MessageT>& publisher, bool allow_loan, FillT&& fill)
+{
+    if (allow_loan && publisher.can_loan_messages()) {
+        auto loaned_message = publisher.borrow_loaned_message();
+        fill(loaned_message.get());
+        publisher.publish(std::move(loaned_message));
+        return;
+    }
+    auto message = std::make_unique<MessageT>();
+    fill(*message);
+    publisher.publish(std::move(message));
+}
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__LOANED_PUBLISH_HPP_
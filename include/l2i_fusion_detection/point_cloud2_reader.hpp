@@ -0,0 +1,189 @@
+#ifndef L2I_FUSION_DETECTION__POINT_CLOUD2_READER_HPP_
+#define L2I_FUSION_DETECTION__POINT_CLOUD2_READER_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "l2i_fusion_detection/point_layouts.hpp"
+
+namespace l2i_fusion_detection
+{
+
+// Reads x, y, z (float32) straight from the data buffer of a PointCloud2 into a PCL cloud
+// that is kept between frames. Unlike pcl::fromROSMsg there is no intermediate
+// PCLPointCloud2 copy, and the output only allocates when a scan is larger than any before.
+// One reader serves one stream: the field layout is inspected when the stream's field list
+// changes, and known driver layouts are decoded by a kernel specialized on them. Only x, y
+// and z are loaded from each record; the other fields of wide driver layouts are skipped.
+class PointCloud2Reader
+{
+public:
+    // Select the decoder for the field layout of msg; true if it differs from the layout in
+    // use (the first message of a stream, or a driver reconfiguration)
+    bool selectLayout(const sensor_msgs::msg::PointCloud2& msg)
+    {
+        if (selected_ && msg.point_step == point_step_ && msg.is_bigendian == is_bigendian_ && msg.fields == fields_) {
+            return false;
+        }
+        selected_ = true;
+        fields_ = msg.fields;
+        point_step_ = msg.point_step;
+        is_bigendian_ = msg.is_bigendian;
+
+        // Every field must lie inside a point record, whichever decoder reads it
+        fields_fit_ = true;
+        for (const auto& field : msg.fields) {
+            const uint64_t size = datatypeSize(field.datatype);
+            if (size == 0 || field.offset + size * field.count > msg.point_step) fields_fit_ = false;
+        }
+
+        if (trySelect<XYZLayout>(msg) || trySelect<XYZILayout>(msg) || trySelect<VelodyneXYZIRTLayout>(msg) ||
+            trySelect<OusterXYZIRTLayout>(msg) || trySelect<HesaiXYZIRTLayout>(msg)) {
+            return true;
+        }
+
+        // Any other little-endian layout with float32 x, y, z is read at its field offsets
+        decoder_ = nullptr;
+        layout_name_ = "unsupported";
+        int offsets[3] = {-1, -1, -1};
+        for (const auto& field : msg.fields) {
+            const int axis = field.name == "x" ? 0 : field.name == "y" ? 1 : field.name == "z" ? 2 : -1;
+            if (axis >= 0 && field.datatype == sensor_msgs::msg::PointField::FLOAT32) {
+                offsets[axis] = static_cast<int>(field.offset);
+            }
+        }
+        if (offsets[0] < 0 || offsets[1] < 0 || offsets[2] < 0 || msg.is_bigendian) return true;
+        std::memcpy(offsets_, offsets, sizeof(offsets_));
+        decoder_ = &PointCloud2Reader::decodeFields;
+        layout_name_ = "generic";
+        return true;
+    }
+
+    // True if msg, whose layout was selected, can be read without leaving its data buffer: its
+    // fields fit in point_step, a row of points fits in row_step, and the buffer holds every row
+    bool wellFormed(const sensor_msgs::msg::PointCloud2& msg) const
+    {
+        return fields_fit_ &&
+               msg.row_step >= static_cast<uint64_t>(msg.width) * msg.point_step &&
+               msg.data.size() >= static_cast<uint64_t>(msg.row_step) * msg.height;
+    }
+
+    // Name of the selected layout, for logging
+    const char* layoutName() const { return layout_name_; }
+
+    // Decode every stride-th column of msg into cloud with the layout selected for it,
+    // keeping its organized layout; false if x, y, z are not little-endian float32 fields or
+    // msg is not well formed, in which case cloud is left untouched
+    bool read(const sensor_msgs::msg::PointCloud2& msg, pcl::PointCloud<pcl::PointXYZ>& cloud, uint32_t stride = 1) const
+    {
+        if (!decoder_ || !wellFormed(msg)) return false;
+
+        const uint32_t width = (msg.width + stride - 1) / stride;
+        cloud.points.resize(static_cast<size_t>(width) * msg.height);
+        cloud.width = width;
+        cloud.height = msg.height;
+        cloud.is_dense = msg.is_dense;
+        cloud.header.frame_id = msg.header.frame_id;
+
+        (this->*decoder_)(msg, cloud, stride);
+        return true;
+    }
+
+    // Keep every stride-th column of an already decoded cloud, in place
+    static void decimate(pcl::PointCloud<pcl::PointXYZ>& cloud, uint32_t stride)
+    {
+        if (stride <= 1 || cloud.width == 0) return;
+        const uint32_t height = static_cast<uint32_t>(cloud.points.size() / cloud.width);
+        const uint32_t width = (cloud.width + stride - 1) / stride;
+        size_t kept = 0;
+        for (uint32_t row = 0; row < height; ++row) {
+            for (uint32_t col = 0; col < cloud.width; col += stride) {
+                cloud.points[kept++] = cloud.points[static_cast<size_t>(row) * cloud.width + col];
+            }
+        }
+        cloud.points.resize(kept);
+        cloud.width = width;
+        cloud.height = height;
+    }
+
+private:
+    using Decoder = void (PointCloud2Reader::*)(const sensor_msgs::msg::PointCloud2&, pcl::PointCloud<pcl::PointXYZ>&, uint32_t) const;
+
+    template <typename Layout>
+    bool trySelect(const sensor_msgs::msg::PointCloud2& msg)
+    {
+        if (!matchesLayout<Layout>(msg)) return false;
+        decoder_ = &PointCloud2Reader::decodeLayout<Layout>;
+        layout_name_ = Layout::name();
+        return true;
+    }
+
+    // Size in bytes of one element of a PointField datatype, 0 if unknown
+    static uint64_t datatypeSize(uint8_t datatype)
+    {
+        switch (datatype) {
+            case sensor_msgs::msg::PointField::INT8:
+            case sensor_msgs::msg::PointField::UINT8: return 1;
+            case sensor_msgs::msg::PointField::INT16:
+            case sensor_msgs::msg::PointField::UINT16: return 2;
+            case sensor_msgs::msg::PointField::INT32:
+            case sensor_msgs::msg::PointField::UINT32:
+            case sensor_msgs::msg::PointField::FLOAT32: return 4;
+            case sensor_msgs::msg::PointField::FLOAT64: return 8;
+            default: return 0;
+        }
+    }
+
+    // Kernel for a known layout: field offsets and point size are compile-time constants, and
+    // only x, y, z are loaded from each record
+    template <typename Layout>
+    void decodeLayout(const sensor_msgs::msg::PointCloud2& msg, pcl::PointCloud<pcl::PointXYZ>& cloud, uint32_t stride) const
+    {
+        const size_t record_step = static_cast<size_t>(stride) * Layout::kPointStep;
+        size_t index = 0;
+        for (uint32_t row = 0; row < msg.height; ++row) {
+            const uint8_t* record = msg.data.data() + static_cast<size_t>(row) * msg.row_step;
+            for (uint32_t col = 0; col < msg.width; col += stride, record += record_step) {
+                auto& point = cloud.points[index++];
+                std::memcpy(&point.x, record, sizeof(float));
+                std::memcpy(&point.y, record + 4, sizeof(float));
+                std::memcpy(&point.z, record + 8, sizeof(float));
+            }
+        }
+    }
+
+    // Kernel for any other layout, reading x, y, z at the offsets found in the field list
+    void decodeFields(const sensor_msgs::msg::PointCloud2& msg, pcl::PointCloud<pcl::PointXYZ>& cloud, uint32_t stride) const
+    {
+        const size_t record_step = static_cast<size_t>(stride) * msg.point_step;
+        size_t index = 0;
+        for (uint32_t row = 0; row < msg.height; ++row) {
+            const uint8_t* record = msg.data.data() + static_cast<size_t>(row) * msg.row_step;
+            for (uint32_t col = 0; col < msg.width; col += stride, record += record_step) {
+                auto& point = cloud.points[index++];
+                std::memcpy(&point.x, record + offsets_[0], sizeof(float));
+                std::memcpy(&point.y, record + offsets_[1], sizeof(float));
+                std::memcpy(&point.z, record + offsets_[2], sizeof(float));
+            }
+        }
+    }
+
+    // Field list the decoder was selected for
+    bool selected_ = false;
+    std::vector<sensor_msgs::msg::PointField> fields_;
+    uint32_t point_step_ = 0;
+    bool is_bigendian_ = false;
+    bool fields_fit_ = false;  // Every field lies inside point_step
+
+    Decoder decoder_ = nullptr;
+    const char* layout_name_ = "unsupported";
+    int offsets_[3] = {-1, -1, -1};  // x, y, z offsets for the generic kernel
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__POINT_CLOUD2_READER_HPP_
@@ -0,0 +1,82 @@
+#ifndef L2I_FUSION_DETECTION__POINT_CLOUD2_WRITER_HPP_
+#define L2I_FUSION_DETECTION__POINT_CLOUD2_WRITER_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Writes packed x, y, z (float32) records, optionally followed by int32 instance_id and
+// class_id, straight into the data buffer of a PointCloud2. The field layout is built
+// once; each message is sized once and filled in place, with no intermediate PCL cloud.
+class PointCloud2Writer
+{
+public:
+    PointCloud2Writer(bool with_instance_id = false, bool with_class_id = false)
+        : with_instance_id_(with_instance_id), with_class_id_(with_class_id)
+    {
+        addField("x", sensor_msgs::msg::PointField::FLOAT32);
+        addField("y", sensor_msgs::msg::PointField::FLOAT32);
+        addField("z", sensor_msgs::msg::PointField::FLOAT32);
+        if (with_instance_id_) addField("instance_id", sensor_msgs::msg::PointField::INT32);
+        if (with_class_id_) addField("class_id", sensor_msgs::msg::PointField::INT32);
+    }
+
+    // Set up msg as an unorganized cloud of num_points points and start writing at its first point
+    void begin(sensor_msgs::msg::PointCloud2& msg, size_t num_points)
+    {
+        msg.fields = fields_;
+        msg.height = 1;
+        msg.width = static_cast<uint32_t>(num_points);
+        msg.is_bigendian = false;
+        msg.point_step = point_step_;
+        msg.row_step = point_step_ * msg.width;
+        msg.is_dense = true;
+        msg.data.resize(static_cast<size_t>(msg.row_step));
+        cursor_ = msg.data.data();
+    }
+
+    // Append the points of one object; instance_id and class_id are written if declared
+    template <typename PointContainer>
+    void write(const PointContainer& points, int32_t instance_id = 0, int32_t class_id = 0)
+    {
+        for (const auto& point : points) {
+            const float xyz[3] = {point.x, point.y, point.z};
+            std::memcpy(cursor_, xyz, sizeof(xyz));
+            uint8_t* next = cursor_ + sizeof(xyz);
+            if (with_instance_id_) {
+                std::memcpy(next, &instance_id, sizeof(int32_t));
+                next += sizeof(int32_t);
+            }
+            if (with_class_id_) {
+                std::memcpy(next, &class_id, sizeof(int32_t));
+            }
+            cursor_ += point_step_;
+        }
+    }
+
+private:
+    void addField(const std::string& name, uint8_t datatype)
+    {
+        sensor_msgs::msg::PointField field;
+        field.name = name;
+        field.offset = point_step_;
+        field.datatype = datatype;
+        field.count = 1;
+        fields_.push_back(field);
+        point_step_ += 4;  // All declared fields are 4 bytes wide
+    }
+
+    bool with_instance_id_, with_class_id_;
+    std::vector<sensor_msgs::msg::PointField> fields_;
+    uint32_t point_step_ = 0;
+    uint8_t* cursor_ = nullptr;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__POINT_CLOUD2_WRITER_HPP_
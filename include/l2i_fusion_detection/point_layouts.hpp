@@ -0,0 +1,127 @@
+#ifndef L2I_FUSION_DETECTION__POINT_LAYOUTS_HPP_
+#define L2I_FUSION_DETECTION__POINT_LAYOUTS_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace l2i_fusion_detection
+{
+
+// PointCloud2 layouts published by common lidar drivers. A decoder specialized on one of
+// them reads x, y, z with fixed loads and steps through the buffer by a fixed point size,
+// instead of looking up field offsets per point. All of them start with PCL's padded x, y, z
+// (float32 at 0, 4 and 8).
+
+struct PointLayoutField {
+    const char* name;
+    uint32_t offset;
+    uint8_t datatype;
+};
+
+// pcl::PointXYZ
+struct XYZLayout {
+    static const char* name() { return "xyz"; }
+    static constexpr uint32_t kPointStep = 16;
+    static const std::array<PointLayoutField, 3>& fields()
+    {
+        static const std::array<PointLayoutField, 3> layout{{
+            {"x", 0, sensor_msgs::msg::PointField::FLOAT32},
+            {"y", 4, sensor_msgs::msg::PointField::FLOAT32},
+            {"z", 8, sensor_msgs::msg::PointField::FLOAT32}}};
+        return layout;
+    }
+};
+
+// pcl::PointXYZI
+struct XYZILayout {
+    static const char* name() { return "xyzi"; }
+    static constexpr uint32_t kPointStep = 32;
+    static const std::array<PointLayoutField, 4>& fields()
+    {
+        static const std::array<PointLayoutField, 4> layout{{
+            {"x", 0, sensor_msgs::msg::PointField::FLOAT32},
+            {"y", 4, sensor_msgs::msg::PointField::FLOAT32},
+            {"z", 8, sensor_msgs::msg::PointField::FLOAT32},
+            {"intensity", 16, sensor_msgs::msg::PointField::FLOAT32}}};
+        return layout;
+    }
+};
+
+// velodyne_pointcloud::PointXYZIRT
+struct VelodyneXYZIRTLayout {
+    static const char* name() { return "velodyne xyzirt"; }
+    static constexpr uint32_t kPointStep = 32;
+    static const std::array<PointLayoutField, 6>& fields()
+    {
+        static const std::array<PointLayoutField, 6> layout{{
+            {"x", 0, sensor_msgs::msg::PointField::FLOAT32},
+            {"y", 4, sensor_msgs::msg::PointField::FLOAT32},
+            {"z", 8, sensor_msgs::msg::PointField::FLOAT32},
+            {"intensity", 16, sensor_msgs::msg::PointField::FLOAT32},
+            {"ring", 20, sensor_msgs::msg::PointField::UINT16},
+            {"time", 24, sensor_msgs::msg::PointField::FLOAT32}}};
+        return layout;
+    }
+};
+
+// ouster_ros::Point (intensity, t, reflectivity, ring, ambient, range)
+struct OusterXYZIRTLayout {
+    static const char* name() { return "ouster xyzirt"; }
+    static constexpr uint32_t kPointStep = 48;
+    static const std::array<PointLayoutField, 9>& fields()
+    {
+        static const std::array<PointLayoutField, 9> layout{{
+            {"x", 0, sensor_msgs::msg::PointField::FLOAT32},
+            {"y", 4, sensor_msgs::msg::PointField::FLOAT32},
+            {"z", 8, sensor_msgs::msg::PointField::FLOAT32},
+            {"intensity", 16, sensor_msgs::msg::PointField::FLOAT32},
+            {"t", 20, sensor_msgs::msg::PointField::UINT32},
+            {"reflectivity", 24, sensor_msgs::msg::PointField::UINT16},
+            {"ring", 26, sensor_msgs::msg::PointField::UINT16},
+            {"ambient", 28, sensor_msgs::msg::PointField::UINT16},
+            {"range", 32, sensor_msgs::msg::PointField::UINT32}}};
+        return layout;
+    }
+};
+
+// Hesai PointXYZIT (intensity, timestamp, ring)
+struct HesaiXYZIRTLayout {
+    static const char* name() { return "hesai xyzirt"; }
+    static constexpr uint32_t kPointStep = 48;
+    static const std::array<PointLayoutField, 6>& fields()
+    {
+        static const std::array<PointLayoutField, 6> layout{{
+            {"x", 0, sensor_msgs::msg::PointField::FLOAT32},
+            {"y", 4, sensor_msgs::msg::PointField::FLOAT32},
+            {"z", 8, sensor_msgs::msg::PointField::FLOAT32},
+            {"intensity", 16, sensor_msgs::msg::PointField::FLOAT32},
+            {"timestamp", 24, sensor_msgs::msg::PointField::FLOAT64},
+            {"ring", 32, sensor_msgs::msg::PointField::UINT16}}};
+        return layout;
+    }
+};
+
+// True if msg carries exactly the fields of Layout, little-endian and with its point size
+template <typename Layout>
+bool matchesLayout(const sensor_msgs::msg::PointCloud2& msg)
+{
+    const auto& layout = Layout::fields();
+    if (msg.is_bigendian || msg.point_step != Layout::kPointStep || msg.fields.size() != layout.size()) return false;
+    for (const auto& expected : layout) {
+        bool found = false;
+        for (const auto& field : msg.fields) {
+            if (field.name == expected.name) {
+                found = field.offset == expected.offset && field.datatype == expected.datatype && field.count == 1;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__POINT_LAYOUTS_HPP_
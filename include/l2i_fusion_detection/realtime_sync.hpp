@@ -0,0 +1,99 @@
+#ifndef L2I_FUSION_DETECTION__REALTIME_SYNC_HPP_
+#define L2I_FUSION_DETECTION__REALTIME_SYNC_HPP_
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <cerrno>
+#include <memory>
+#include <mutex>
+
+namespace l2i_fusion_detection
+{
+
+// Mutex with priority inheritance: a thread holding it runs at the priority of the highest
+// priority thread waiting for it, so a SCHED_FIFO thread is not held up for long by a normal
+// priority thread that was preempted inside a short critical section. Falls back to a plain
+// mutex where the protocol is not supported. Usable with std::lock_guard and std::unique_lock.
+class PriorityInheritanceMutex
+{
+public:
+    PriorityInheritanceMutex()
+    {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+        pthread_mutex_init(&mutex_, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+    }
+
+    ~PriorityInheritanceMutex() { pthread_mutex_destroy(&mutex_); }
+
+    PriorityInheritanceMutex(const PriorityInheritanceMutex&) = delete;
+    PriorityInheritanceMutex& operator=(const PriorityInheritanceMutex&) = delete;
+
+    void lock() { pthread_mutex_lock(&mutex_); }
+    bool try_lock() { return pthread_mutex_trylock(&mutex_) == 0; }
+    void unlock() { pthread_mutex_unlock(&mutex_); }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+// Counting semaphore. post() takes no lock and never waits (an atomic update, plus a futex
+// wake when a thread is waiting), so a real-time thread can signal a normal priority one.
+class Semaphore
+{
+public:
+    explicit Semaphore(unsigned int count = 0) { sem_init(&semaphore_, 0, count); }
+    ~Semaphore() { sem_destroy(&semaphore_); }
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    void post() { sem_post(&semaphore_); }
+
+    // Wait until the count is positive and decrement it
+    void wait()
+    {
+        while (sem_wait(&semaphore_) != 0 && errno == EINTR) {
+        }
+    }
+
+    // Decrement the count if it is positive, without waiting
+    bool tryWait() { return sem_trywait(&semaphore_) == 0; }
+
+private:
+    sem_t semaphore_;
+};
+
+// Reference to an immutable snapshot that a writer replaces as a whole while readers keep
+// using the one they loaded. Replaces std::atomic_load/store on shared_ptr, which lock a
+// process-wide pool of plain mutexes shared with every other such access; here the lock is
+// private and inherits priority, and is only held to copy or swap the reference.
+template <typename T>
+class SnapshotHolder
+{
+public:
+    std::shared_ptr<const T> load() const
+    {
+        std::lock_guard<PriorityInheritanceMutex> lock(mutex_);
+        return snapshot_;
+    }
+
+    void store(std::shared_ptr<const T> snapshot)
+    {
+        {
+            std::lock_guard<PriorityInheritanceMutex> lock(mutex_);
+            snapshot_.swap(snapshot);
+        }
+        // The previous snapshot is released here, outside the lock
+    }
+
+private:
+    mutable PriorityInheritanceMutex mutex_;
+    std::shared_ptr<const T> snapshot_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__REALTIME_SYNC_HPP_
@@ -0,0 +1,140 @@
+#ifndef L2I_FUSION_DETECTION__VOXEL_CLUSTERING_HPP_
+#define L2I_FUSION_DETECTION__VOXEL_CLUSTERING_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include "l2i_fusion_detection/voxel_hash_map.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Euclidean clustering on a voxel grid: points share a cluster when their voxels
+// (edge length = tolerance) touch, including diagonally. Voxels are merged with
+// union-find, so the whole pass is linear in the number of points.
+class VoxelClustering
+{
+public:
+    enum class Selection { Largest, Nearest };
+
+    // Allocate storage up front for clouds of up to max_points points
+    void reserve(size_t max_points)
+    {
+        voxels_.reserve(max_points);
+        voxel_coords_.reserve(max_points);
+        point_voxel_.reserve(max_points);
+        parent_.reserve(max_points);
+        cluster_count_.reserve(max_points);
+        cluster_depth_.reserve(max_points);
+    }
+
+    // Write the indices of the selected cluster of cloud into indices. Clusters smaller
+    // than min_points are ignored unless no cluster reaches that size.
+    void extract(const pcl::PointCloud<pcl::PointXYZ>& cloud, float tolerance, size_t min_points,
+                 Selection selection, std::vector<int>& indices)
+    {
+        indices.clear();
+        const size_t num_points = cloud.points.size();
+        if (num_points == 0) return;
+
+        // Assign every point to a voxel
+        const float inv_tolerance = 1.0f / tolerance;
+        voxels_.clear(num_points);
+        voxel_coords_.clear();
+        point_voxel_.resize(num_points);
+        for (size_t i = 0; i < num_points; ++i) {
+            const auto& point = cloud.points[i];
+            const int vx = static_cast<int>(std::floor(point.x * inv_tolerance));
+            const int vy = static_cast<int>(std::floor(point.y * inv_tolerance));
+            const int vz = static_cast<int>(std::floor(point.z * inv_tolerance));
+            bool inserted;
+            point_voxel_[i] = voxels_.insert(packVoxelKey(vx, vy, vz), static_cast<int>(voxel_coords_.size()), inserted);
+            if (inserted) voxel_coords_.push_back({vx, vy, vz});
+        }
+
+        // Union each voxel with its occupied neighbours; half of the 26-neighbourhood suffices
+        static const int kForwardNeighbours[13][3] = {
+            {1, -1, -1}, {1, -1, 0}, {1, -1, 1}, {1, 0, -1}, {1, 0, 0}, {1, 0, 1}, {1, 1, -1},
+            {1, 1, 0}, {1, 1, 1}, {0, 1, -1}, {0, 1, 0}, {0, 1, 1}, {0, 0, 1}};
+        const size_t num_voxels = voxel_coords_.size();
+        parent_.resize(num_voxels);
+        for (size_t v = 0; v < num_voxels; ++v) parent_[v] = static_cast<int>(v);
+        for (size_t v = 0; v < num_voxels; ++v) {
+            const VoxelCoord& c = voxel_coords_[v];
+            for (const auto& offset : kForwardNeighbours) {
+                const int neighbour = voxels_.find(packVoxelKey(c.x + offset[0], c.y + offset[1], c.z + offset[2]));
+                if (neighbour >= 0) unite(static_cast<int>(v), neighbour);
+            }
+        }
+
+        // Accumulate size and depth per cluster root
+        cluster_count_.assign(num_voxels, 0);
+        cluster_depth_.assign(num_voxels, 0.0);
+        for (size_t i = 0; i < num_points; ++i) {
+            const int root = find(point_voxel_[i]);
+            point_voxel_[i] = root;
+            cluster_count_[root]++;
+            cluster_depth_[root] += cloud.points[i].z;
+        }
+
+        // Pick the largest cluster, or the nearest one among those large enough
+        int best = -1;
+        int largest = -1;
+        double best_depth = std::numeric_limits<double>::max();
+        for (size_t r = 0; r < num_voxels; ++r) {
+            const size_t count = cluster_count_[r];
+            if (count == 0) continue;
+            if (largest < 0 || count > cluster_count_[largest]) largest = static_cast<int>(r);
+            if (count < min_points) continue;
+            if (selection == Selection::Largest) {
+                if (best < 0 || count > cluster_count_[best]) best = static_cast<int>(r);
+            } else {
+                const double depth = cluster_depth_[r] / count;
+                if (depth < best_depth) {
+                    best_depth = depth;
+                    best = static_cast<int>(r);
+                }
+            }
+        }
+        if (best < 0) best = largest;
+
+        indices.reserve(cluster_count_[best]);
+        for (size_t i = 0; i < num_points; ++i) {
+            if (point_voxel_[i] == best) indices.push_back(static_cast<int>(i));
+        }
+    }
+
+private:
+    struct VoxelCoord { int x, y, z; };
+
+    int find(int v)
+    {
+        while (parent_[v] != v) {
+            parent_[v] = parent_[parent_[v]];  // Path halving
+            v = parent_[v];
+        }
+        return v;
+    }
+
+    void unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent_[std::max(a, b)] = std::min(a, b);
+    }
+
+    VoxelHashMap voxels_;
+    std::vector<VoxelCoord> voxel_coords_;
+    std::vector<int> point_voxel_;
+    std::vector<int> parent_;
+    std::vector<size_t> cluster_count_;
+    std::vector<double> cluster_depth_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__VOXEL_CLUSTERING_HPP_
@@ -0,0 +1,73 @@
+#ifndef L2I_FUSION_DETECTION__VOXEL_DOWNSAMPLING_HPP_
+#define L2I_FUSION_DETECTION__VOXEL_DOWNSAMPLING_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include "l2i_fusion_detection/voxel_hash_map.hpp"
+#include <cmath>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Voxel grid filter on a hash grid: each occupied voxel is replaced by the centroid of
+// its points. Linear in the number of points, and unlike pcl::VoxelGrid it needs no
+// bounding box pass and no sort.
+class VoxelDownsampling
+{
+public:
+    // Allocate storage up front for clouds of up to max_points points
+    void reserve(size_t max_points)
+    {
+        voxels_.reserve(max_points);
+        sums_.reserve(max_points);
+    }
+
+    // Downsample cloud in place with voxels of edge leaf_size (meters)
+    void filter(pcl::PointCloud<pcl::PointXYZ>& cloud, float leaf_size)
+    {
+        const size_t num_points = cloud.points.size();
+        if (num_points == 0) return;
+
+        const float inv_leaf_size = 1.0f / leaf_size;
+        voxels_.clear(num_points);
+        sums_.clear();
+        for (const auto& point : cloud.points) {
+            const int vx = static_cast<int>(std::floor(point.x * inv_leaf_size));
+            const int vy = static_cast<int>(std::floor(point.y * inv_leaf_size));
+            const int vz = static_cast<int>(std::floor(point.z * inv_leaf_size));
+            bool inserted;
+            const int voxel = voxels_.insert(packVoxelKey(vx, vy, vz), static_cast<int>(sums_.size()), inserted);
+            if (inserted) sums_.push_back(VoxelSum());
+            VoxelSum& sum = sums_[voxel];
+            sum.x += point.x;
+            sum.y += point.y;
+            sum.z += point.z;
+            sum.count++;
+        }
+
+        // Voxels keep the order in which they were first seen
+        cloud.points.resize(sums_.size());
+        for (size_t v = 0; v < sums_.size(); ++v) {
+            const VoxelSum& sum = sums_[v];
+            cloud.points[v].x = sum.x / sum.count;
+            cloud.points[v].y = sum.y / sum.count;
+            cloud.points[v].z = sum.z / sum.count;
+        }
+        cloud.width = static_cast<uint32_t>(cloud.points.size());
+        cloud.height = 1;
+    }
+
+private:
+    struct VoxelSum {
+        float x = 0, y = 0, z = 0;  // Accumulated point coordinates in this voxel
+        int count = 0;  // Number of points in this voxel
+    };
+
+    VoxelHashMap voxels_;
+    std::vector<VoxelSum> sums_;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__VOXEL_DOWNSAMPLING_HPP_
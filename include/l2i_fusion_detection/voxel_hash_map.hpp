@@ -0,0 +1,96 @@
+#ifndef L2I_FUSION_DETECTION__VOXEL_HASH_MAP_HPP_
+#define L2I_FUSION_DETECTION__VOXEL_HASH_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace l2i_fusion_detection
+{
+
+// Pack integer voxel coordinates (21 bits each) into a single hash key
+inline uint64_t packVoxelKey(int x, int y, int z)
+{
+    const uint64_t mask = (1u << 21) - 1;
+    return ((static_cast<uint64_t>(x + (1 << 20)) & mask) << 42) |
+           ((static_cast<uint64_t>(y + (1 << 20)) & mask) << 21) |
+           (static_cast<uint64_t>(z + (1 << 20)) & mask);
+}
+
+// Marks an unused slot of VoxelHashMap; never produced by packVoxelKey
+const uint64_t kEmptyVoxelKey = std::numeric_limits<uint64_t>::max();
+
+// Flat open-addressing hash map from packed voxel key to a dense voxel index.
+// Storage is kept between frames, so clearing and refilling does not allocate
+// once the table has grown to the working size.
+class VoxelHashMap
+{
+public:
+    // Allocate storage up front for tables of up to max_voxels insertions
+    void reserve(size_t max_voxels)
+    {
+        keys_.reserve(capacityFor(max_voxels));
+        values_.reserve(capacityFor(max_voxels));
+    }
+
+    // Prepare the table for up to max_voxels insertions
+    void clear(size_t max_voxels)
+    {
+        const size_t capacity = capacityFor(max_voxels);
+        keys_.assign(capacity, kEmptyVoxelKey);
+        values_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    // Index stored for key, or -1 if absent
+    int find(uint64_t key) const
+    {
+        for (size_t slot = hash(key) & mask_;; slot = (slot + 1) & mask_) {
+            if (keys_[slot] == key) return values_[slot];
+            if (keys_[slot] == kEmptyVoxelKey) return -1;
+        }
+    }
+
+    // Index stored for key; inserts next_index if absent and sets inserted
+    int insert(uint64_t key, int next_index, bool& inserted)
+    {
+        for (size_t slot = hash(key) & mask_;; slot = (slot + 1) & mask_) {
+            if (keys_[slot] == key) {
+                inserted = false;
+                return values_[slot];
+            }
+            if (keys_[slot] == kEmptyVoxelKey) {
+                keys_[slot] = key;
+                values_[slot] = next_index;
+                inserted = true;
+                return next_index;
+            }
+        }
+    }
+
+private:
+    // Power-of-two slot count keeping the load factor at or below one half
+    static size_t capacityFor(size_t max_voxels)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * max_voxels) capacity <<= 1;
+        return capacity;
+    }
+
+    static size_t hash(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    std::vector<uint64_t> keys_;
+    std::vector<int> values_;
+    size_t mask_ = 0;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__VOXEL_HASH_MAP_HPP_
@@ -0,0 +1,172 @@
+#ifndef L2I_FUSION_DETECTION__WORKER_POOL_HPP_
+#define L2I_FUSION_DETECTION__WORKER_POOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "l2i_fusion_detection/allocation_counter.hpp"
+
+namespace l2i_fusion_detection
+{
+
+// Fixed set of worker threads started once and reused for every frame. parallelFor splits
+// [0, count) into contiguous chunks that the calling thread and any idle worker claim one
+// at a time, and returns when all chunks are done. Several threads may call parallelFor at
+// once (pipeline stages, or fusion nodes sharing one pool): their jobs are queued and
+// workers serve whichever has chunks left. Dispatch does not allocate: the job lives on the
+// caller's stack and the callable is passed by reference and type-erased into a function pointer.
+// Allocations the workers make while running a job's chunks are attributed to the thread that
+// called parallelFor (see AllocationCounter), so a caller's count covers its whole job and
+// nothing of the jobs of other callers.
+class WorkerPool
+{
+public:
+    // on_start, if given, runs first on every worker thread with its thread index
+    explicit WorkerPool(size_t num_threads, void (*on_start)(size_t thread) = nullptr)
+        : num_threads_(num_threads > 0 ? num_threads : 1), on_start_(on_start)
+    {
+        for (size_t t = 1; t < num_threads_; ++t) {
+            workers_.emplace_back(&WorkerPool::workerLoop, this, t);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Number of threads taking part in parallelFor, including the caller
+    size_t size() const { return num_threads_; }
+
+    // Worker threads, e.g. to adjust their scheduling
+    std::vector<std::thread>& threads() { return workers_; }
+
+    // Run fn(thread, start, end) over [0, count); thread indexes per-thread workspaces. The
+    // caller is thread 0, so concurrent callers must not share the workspaces they index.
+    template <typename Fn>
+    void parallelFor(size_t count, Fn& fn)
+    {
+        Job job;
+        job.task = &invoke<Fn>;
+        job.context = &fn;
+        job.count = count;
+        job.num_chunks = std::min(num_threads_, std::max<size_t>(count, 1));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (jobs_tail_) {
+                jobs_tail_->next = &job;
+            } else {
+                jobs_head_ = &job;
+            }
+            jobs_tail_ = &job;
+        }
+        if (job.num_chunks > 1) start_cv_.notify_all();
+
+        // The caller works on its own job too, so it completes even while every worker is
+        // busy with other callers
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (job.next_chunk < job.num_chunks) {
+            const size_t chunk = claimLocked(job);
+            lock.unlock();
+            runChunk(job, 0, chunk);
+            lock.lock();
+            job.done++;
+        }
+        done_cv_.wait(lock, [&job]() { return job.done == job.num_chunks; });
+        AllocationCounter::attribute(job.worker_allocations);
+    }
+
+private:
+    using Task = void (*)(void*, size_t, size_t, size_t);
+
+    // One parallelFor call; queued while it has unclaimed chunks
+    struct Job {
+        Task task = nullptr;
+        void* context = nullptr;
+        size_t count = 0, num_chunks = 0;
+        size_t next_chunk = 0, done = 0;
+        uint64_t worker_allocations = 0;  // Allocations made by workers running its chunks
+        Job* next = nullptr;
+    };
+
+    template <typename Fn>
+    static void invoke(void* context, size_t thread, size_t start, size_t end)
+    {
+        (*static_cast<Fn*>(context))(thread, start, end);
+    }
+
+    // Take the next chunk of job, dequeuing it once all its chunks are taken
+    size_t claimLocked(Job& job)
+    {
+        const size_t chunk = job.next_chunk++;
+        if (job.next_chunk == job.num_chunks) {
+            Job** link = &jobs_head_;
+            Job* previous = nullptr;
+            while (*link != &job) {
+                previous = *link;
+                link = &previous->next;
+            }
+            *link = job.next;
+            if (jobs_tail_ == &job) jobs_tail_ = previous;
+        }
+        return chunk;
+    }
+
+    static void runChunk(const Job& job, size_t thread, size_t chunk)
+    {
+        job.task(job.context, thread, chunk * job.count / job.num_chunks, (chunk + 1) * job.count / job.num_chunks);
+    }
+
+    void workerLoop(size_t thread)
+    {
+        if (on_start_) on_start_(thread);
+        while (true) {
+            Job* job;
+            size_t chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock, [this]() { return stop_ || jobs_head_ != nullptr; });
+                if (stop_) return;
+                job = jobs_head_;  // Oldest job first
+                chunk = claimLocked(*job);
+            }
+
+            const uint64_t allocations_at_start = AllocationCounter::count();
+            runChunk(*job, thread, chunk);
+            const uint64_t allocations = AllocationCounter::count() - allocations_at_start;
+
+            // The caller may return and destroy the job as soon as the last chunk is counted
+            std::lock_guard<std::mutex> lock(mutex_);
+            job->worker_allocations += allocations;
+            if (++job->done == job->num_chunks) done_cv_.notify_all();
+        }
+    }
+
+    const size_t num_threads_;
+    void (*on_start_)(size_t);
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_, done_cv_;
+    Job* jobs_head_ = nullptr;
+    Job* jobs_tail_ = nullptr;
+    bool stop_ = false;
+};
+
+}  // namespace l2i_fusion_detection
+
+#endif  // L2I_FUSION_DETECTION__WORKER_POOL_HPP_
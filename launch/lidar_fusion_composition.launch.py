@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+
+from launch import LaunchDescription
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+
+def generate_launch_description():
+    ld = LaunchDescription()
+
+    # Lidar-Camera Fusion component, with intra-process communication enabled so that
+    # consumers loaded into the same container (tracker, planner, ...) receive the
+    # fused image, poses and object clouds without serialization or copies
+    lidar_camera_fusion_component = ComposableNode(
+        package='l2i_fusion_detection',
+        plugin='l2i_fusion_detection::LidarCameraFusionNode',
+        name='lidar_camera_fusion_node',
+        parameters=[
+            {'min_range': 0.2, 'max_range': 10.0,
+             'lidar_frame': 'x500_lidar_camera_1/lidar_link/gpu_lidar',
+             'camera_frame': 'observer/gimbal_camera'}
+        ],
+        remappings=[
+            ('/scan/points', '/scan/points'),
+            ('/observer/gimbal_camera_info', '/observer/gimbal_camera_info'),
+            ('/observer/gimbal_camera', '/observer/gimbal_camera'),
+            ('/rgb/tracking', '/rgb/tracking')
+        ],
+        extra_arguments=[{'use_intra_process_comms': True}]
+    )
+
+    # Container hosting the fusion component; add consumer components to this list. It is
+    # multi-threaded, so the component's callback groups run concurrently
+    fusion_container = ComposableNodeContainer(
+        name='lidar_camera_fusion_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container_mt',
+        composable_node_descriptions=[
+            lidar_camera_fusion_component,
+        ],
+        output='screen'
+    )
+
+    ld.add_action(fusion_container)
+
+    return ld
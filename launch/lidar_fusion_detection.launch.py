@@ -147,7 +147,46 @@ def generate_launch_description():
         parameters=[
             {'min_range': 0.2, 'max_range': 10.0,
              'lidar_frame': 'x500_lidar_camera_1/lidar_link/gpu_lidar',
-             'camera_frame': 'observer/gimbal_camera'}
+             'camera_frame': 'observer/gimbal_camera',
+             'camera_sync_tolerance': 0.05,
+             'lidar_sync_tolerance': 0.05,
+             'use_depth_histogram': True,
+             'depth_histogram_bin_width': 0.25,
+             'depth_histogram_peak_ratio': 0.5,
+             'association_mode': 'bbox',
+             'use_distortion': True,
+             'use_clustering': False,
+             'cluster_tolerance': 0.3,
+             'cluster_min_points': 5,
+             'cluster_selection': 'largest',
+             'use_ground_removal': False,
+             'ground_max_slope': 10.0,
+             'ground_distance_threshold': 0.15,
+             'ground_ransac_iterations': 25,
+             'object_cloud_leaf_size': 0.0,
+             'batch_object_clouds': True,
+             'publish_class_id': False,
+             'use_loaned_messages': True,
+             'shared_worker_pool': True,
+             'realtime': False,
+             'realtime_priority': 80,
+             'max_points': 131072,
+             'max_boxes': 64,
+             'max_object_points': 16384,
+             'transform_refresh_period': 0.1,
+             'latency_budget': 0.0,
+             'late_frame_policy': 'drop',
+             'adaptive_decimation': False,
+             'decimation_latency_budget': 0.05,
+             'decimation_window': 100,
+             'max_decimation_stride': 8,
+             'pipeline': False,
+             'pipeline_depth': 4,
+             'executor': 'multi_threaded',
+             'executor_threads': 4,
+             'metrics_period': 1.0,
+             'allocation_check_warmup_frames': 20,
+             'fail_on_steady_state_allocation': False}
         ],
         remappings=[
             ('/scan/points', '/scan/points'),
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+
+from launch import LaunchDescription
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+
+# Namespaces of the robot stacks to fuse; each gets its own fusion pipeline in one process
+ROBOTS = ['observer_1', 'observer_2']
+
+
+def fusion_component(robot):
+    # One fusion pipeline per robot: topics, frames and calibration are taken from the
+    # robot's namespace, the worker threads are shared with the other pipelines
+    return ComposableNode(
+        package='l2i_fusion_detection',
+        plugin='l2i_fusion_detection::LidarCameraFusionNode',
+        name='lidar_camera_fusion_node',
+        namespace=robot,
+        parameters=[
+            {'min_range': 0.2, 'max_range': 10.0,
+             'lidar_frame': robot + '/lidar_link/gpu_lidar',
+             'camera_frame': robot + '/gimbal_camera',
+             'shared_worker_pool': True}
+        ],
+        remappings=[
+            ('/scan/points', '/' + robot + '/scan/points'),
+            ('/observer/gimbal_camera_info', '/' + robot + '/gimbal_camera_info'),
+            ('/observer/gimbal_camera', '/' + robot + '/gimbal_camera'),
+            ('/rgb/tracking', '/' + robot + '/rgb/tracking'),
+            ('/image_lidar_fusion', '/' + robot + '/image_lidar_fusion'),
+            ('/detected_object_pose', '/' + robot + '/detected_object_pose'),
+            ('/detected_object_point_cloud', '/' + robot + '/detected_object_point_cloud')
+        ],
+        extra_arguments=[{'use_intra_process_comms': True}]
+    )
+
+
+def generate_launch_description():
+    ld = LaunchDescription()
+
+    # Multi-threaded container, so the pipelines of different robots run concurrently
+    fusion_container = ComposableNodeContainer(
+        name='lidar_camera_fusion_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container_mt',
+        composable_node_descriptions=[fusion_component(robot) for robot in ROBOTS],
+        output='screen'
+    )
+
+    ld.add_action(fusion_container)
+
+    return ld
@@ -0,0 +1,44 @@
+#include "l2i_fusion_detection/allocation_counter.hpp"
+
+// Defined by counting_allocator.cpp only: its address is null unless the program links the
+// counting allocation functions
+extern "C" __attribute__((weak)) const bool l2i_counting_allocator_linked;
+
+namespace l2i_fusion_detection
+{
+
+namespace
+{
+// Plain thread-locals: record() runs inside malloc and must neither lock nor allocate
+thread_local bool thread_tracked = false;
+thread_local uint64_t thread_allocations = 0;
+}  // namespace
+
+bool AllocationCounter::enabled()
+{
+    return &l2i_counting_allocator_linked != nullptr;
+}
+
+void AllocationCounter::trackCurrentThread(bool track)
+{
+    thread_tracked = track;
+}
+
+uint64_t AllocationCounter::count()
+{
+    return thread_allocations;
+}
+
+void AllocationCounter::attribute(uint64_t allocations)
+{
+    thread_allocations += allocations;
+}
+
+void AllocationCounter::record()
+{
+    if (thread_tracked) {
+        ++thread_allocations;
+    }
+}
+
+}  // namespace l2i_fusion_detection
@@ -0,0 +1,120 @@
+// Replacement heap entry points that report every allocation to AllocationCounter.
+// Linked into the standalone executable and the tests only when they are built with
+// -DL2I_COUNT_ALLOCATIONS=ON: replacements must live in the main program to take effect,
+// which a component loaded into a container with dlopen cannot guarantee.
+//
+// On glibc the malloc family is interposed, which also covers operator new and the
+// Eigen aligned allocator used by PCL clouds. Elsewhere only operator new is replaced.
+
+#include "l2i_fusion_detection/allocation_counter.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+// Tells AllocationCounter::enabled() that the counting functions are linked into this program
+extern "C" __attribute__((visibility("default"))) const bool l2i_counting_allocator_linked = true;
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+    l2i_fusion_detection::AllocationCounter::record();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    l2i_fusion_detection::AllocationCounter::record();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    l2i_fusion_detection::AllocationCounter::record();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    l2i_fusion_detection::AllocationCounter::record();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+    void* result = memalign(alignment, size);
+    if (!result) return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+
+}  // extern "C"
+
+#else
+
+void* operator new(std::size_t size)
+{
+    l2i_fusion_detection::AllocationCounter::record();
+    if (size == 0) size = 1;
+    while (true) {
+        if (void* ptr = std::malloc(size)) return ptr;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif  // __GLIBC__
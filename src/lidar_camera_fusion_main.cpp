@@ -0,0 +1,18 @@
+#include <rclcpp/rclcpp.hpp>
+#include "l2i_fusion_detection/lidar_camera_fusion_node.hpp"
+
+int main(int argc, char** argv)
+{
+    rclcpp::init(argc, argv);  // Initialize ROS2
+    auto node = std::make_shared<l2i_fusion_detection::LidarCameraFusionNode>();  // Create node
+    if (node->useMultiThreadedExecutor()) {
+        // Callback groups of the node run concurrently, one callback per group at a time
+        rclcpp::executors::MultiThreadedExecutor executor(rclcpp::ExecutorOptions(), node->executorThreads());
+        executor.add_node(node);
+        executor.spin();  // Run node
+    } else {
+        rclcpp::spin(node);  // Run node
+    }
+    rclcpp::shutdown();  // Shutdown ROS2
+    return 0;
+}
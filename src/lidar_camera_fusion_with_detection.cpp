@@ -1,348 +1,1620 @@
-#include <rclcpp/rclcpp.hpp>
-#include <sensor_msgs/msg/point_cloud2.hpp>
-#include <sensor_msgs/msg/image.hpp>
-#include <yolo_msgs/msg/detection_array.hpp>
-#include <geometry_msgs/msg/pose_array.hpp>
-#include <image_geometry/pinhole_camera_model.h>
+#include "l2i_fusion_detection/lidar_camera_fusion_node.hpp"
+
 #include <cv_bridge/cv_bridge.h>
 #include <pcl_conversions/pcl_conversions.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-#include <pcl/filters/crop_box.h>
-#include <pcl/common/transforms.h>
-#include <tf2_ros/buffer.h>
-#include <tf2_ros/transform_listener.h>
 #include <tf2_eigen/tf2_eigen.hpp>
-#include <opencv2/opencv.hpp>
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
+#include <rclcpp_components/register_node_macro.hpp>
+#include "l2i_fusion_detection/loaned_publish.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <thread>
-#include <vector>
 #include <mutex>
+#include <utility>
 
+namespace l2i_fusion_detection
+{
 
-class LidarCameraFusionNode : public rclcpp::Node
+namespace
 {
-public:
-    LidarCameraFusionNode()
-        : Node("lidar_camera_fusion_node"),
-          tf_buffer_(this->get_clock()),  // Initialize TF2 buffer
-          tf_listener_(tf_buffer_)        // Initialize TF2 listener
-    {
-        declare_parameters();  // Declare and load parameters
-        initialize_subscribers_and_publishers();  // Set up subscribers and publishers
-    }
-
-private:
-    // Structure to hold bounding box information
-    struct BoundingBox {
-        double x_min, y_min, x_max, y_max;  // Bounding box coordinates in image space
-        double sum_x = 0, sum_y = 0, sum_z = 0;  // Accumulated point coordinates for averaging
-        int count = 0;  // Number of points in the bounding box
-        bool valid = false;  // Flag to indicate if the bounding box is valid
-        int id = -1;  // ID of the detected object
-        pcl::PointCloud<pcl::PointXYZ>::Ptr object_cloud = nullptr;  // Point cloud for the object
-    };
 
-    // Declare and load parameters from the parameter server
-    void declare_parameters()
-    {
-        declare_parameter<std::string>("lidar_frame", "x500_mono_1/lidar_link/gpu_lidar");
-        declare_parameter<std::string>("camera_frame", "observer/gimbal_camera");
-        declare_parameter<float>("min_range", 0.2);
-        declare_parameter<float>("max_range", 10.0);
+// Refreshes of the real-time extrinsics kept for interpolation (1 s at the default period)
+constexpr size_t kExtrinsicsHistorySize = 10;
+
+// Transform stamp in seconds
+double stampSeconds(const geometry_msgs::msg::TransformStamped& transform)
+{
+    return rclcpp::Time(transform.header.stamp).seconds();
+}
+
+// Worker threads only ever run fusion work, so their allocations are always counted
+void trackWorkerThread(size_t /*thread*/)
+{
+    AllocationCounter::trackCurrentThread(true);
+}
+
+// Worker pool shared by all fusion nodes of the process, kept while any of them uses it
+std::shared_ptr<WorkerPool> sharedWorkerPool()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<WorkerPool> shared_pool;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<WorkerPool> pool = shared_pool.lock();
+    if (!pool) {
+        pool = std::make_shared<WorkerPool>(std::max(1u, std::thread::hardware_concurrency()), &trackWorkerThread);
+        shared_pool = pool;
+    }
+    return pool;
+}
+
+}  // namespace
+
+LidarCameraFusionNode::LidarCameraFusionNode(const rclcpp::NodeOptions& options)
+    : Node("lidar_camera_fusion_node", options),
+      tf_buffer_(this->get_clock()),  // Initialize TF2 buffer
+      tf_listener_(tf_buffer_),       // Initialize TF2 listener
+      use_intra_process_comms_(options.use_intra_process_comms())
+{
+    declare_parameters();  // Declare and load parameters
+    if (realtime_) {
+        preallocateWorkspaces();  // Size every per-frame buffer before the first frame
+    }
+    initialize_subscribers_and_publishers();  // Set up subscribers and publishers
+    if (pipeline_ || realtime_) {
+        startPipeline();  // One thread per stage; real-time mode only runs the publish stage
+    }
+    if (realtime_) {
+        startRealtimeThread();  // Lock memory and start (or reschedule) the processing threads
+    }
+}
+
+LidarCameraFusionNode::~LidarCameraFusionNode()
+{
+    if (realtime_thread_.joinable()) {
+        realtime_stop_ = true;
+        realtime_wakeup_.post();
+        realtime_thread_.join();
+    }
+    if (free_workspaces_) {
+        for (auto& queue : stage_queues_) {
+            queue->close();
+        }
+        free_workspaces_->close();
+        for (auto& thread : pipeline_threads_) {
+            thread.join();
+        }
+    }
+}
+
+// Declare and load parameters from the parameter server
+void LidarCameraFusionNode::declare_parameters()
+{
+    declare_parameter<std::string>("lidar_frame", "x500_mono_1/lidar_link/gpu_lidar");
+    declare_parameter<std::string>("camera_frame", "observer/gimbal_camera");
+    declare_parameter<float>("min_range", 0.2);
+    declare_parameter<float>("max_range", 10.0);
+    declare_parameter<bool>("use_depth_histogram", true);
+    declare_parameter<float>("depth_histogram_bin_width", 0.25);
+    declare_parameter<float>("depth_histogram_peak_ratio", 0.5);
+    declare_parameter<std::string>("association_mode", "bbox");
+    declare_parameter<bool>("use_distortion", true);
+    declare_parameter<bool>("use_clustering", false);
+    declare_parameter<float>("cluster_tolerance", 0.3);
+    declare_parameter<int>("cluster_min_points", 5);
+    declare_parameter<std::string>("cluster_selection", "largest");
+    declare_parameter<bool>("use_ground_removal", false);
+    declare_parameter<float>("ground_max_slope", 10.0);
+    declare_parameter<float>("ground_distance_threshold", 0.15);
+    declare_parameter<int>("ground_ransac_iterations", 25);
+    declare_parameter<float>("object_cloud_leaf_size", 0.0);
+    declare_parameter<bool>("batch_object_clouds", true);
+    declare_parameter<bool>("publish_class_id", false);
+    declare_parameter<bool>("use_loaned_messages", true);
+    declare_parameter<bool>("shared_worker_pool", true);
+    declare_parameter<bool>("realtime", false);
+    declare_parameter<int>("realtime_priority", 80);
+    declare_parameter<std::vector<int64_t>>("realtime_cpus", std::vector<int64_t>{});
+    declare_parameter<int>("max_points", 131072);
+    declare_parameter<int>("max_boxes", 64);
+    declare_parameter<int>("max_object_points", 16384);
+    declare_parameter<double>("transform_refresh_period", 0.1);
+    declare_parameter<bool>("adaptive_decimation", false);
+    declare_parameter<double>("decimation_latency_budget", 0.05);
+    declare_parameter<int>("decimation_window", 100);
+    declare_parameter<int>("max_decimation_stride", 8);
+    declare_parameter<bool>("pipeline", false);
+    declare_parameter<int>("pipeline_depth", 4);
+    declare_parameter<double>("latency_budget", 0.0);
+    declare_parameter<std::string>("late_frame_policy", "drop");
+    declare_parameter<std::string>("executor", "multi_threaded");
+    declare_parameter<int>("executor_threads", 4);
+    declare_parameter<double>("metrics_period", 1.0);
+    declare_parameter<int>("allocation_check_warmup_frames", 20);
+    declare_parameter<bool>("fail_on_steady_state_allocation", false);
+
+    get_parameter("lidar_frame", lidar_frame_);
+    get_parameter("camera_frame", camera_frame_);
+    declare_cameras();  // Camera list, per-camera topics and frames
+    declare_lidars();  // Lidar list, per-lidar topics and frames
+    get_parameter("min_range", min_range_);
+    get_parameter("max_range", max_range_);
+    get_parameter("use_depth_histogram", use_depth_histogram_);
+    get_parameter("depth_histogram_bin_width", depth_histogram_bin_width_);
+    get_parameter("depth_histogram_peak_ratio", depth_histogram_peak_ratio_);
+    get_parameter("association_mode", association_mode_);
+    get_parameter("use_distortion", use_distortion_);
+    get_parameter("use_clustering", use_clustering_);
+    get_parameter("cluster_tolerance", cluster_tolerance_);
+    get_parameter("cluster_min_points", cluster_min_points_);
+    get_parameter("cluster_selection", cluster_selection_);
+    bool use_ground_removal;
+    float ground_max_slope, ground_distance_threshold;
+    int ground_ransac_iterations;
+    get_parameter("use_ground_removal", use_ground_removal);
+    get_parameter("ground_max_slope", ground_max_slope);
+    get_parameter("ground_distance_threshold", ground_distance_threshold);
+    get_parameter("ground_ransac_iterations", ground_ransac_iterations);
+    get_parameter("object_cloud_leaf_size", object_cloud_leaf_size_);
+    get_parameter("batch_object_clouds", batch_object_clouds_);
+    get_parameter("publish_class_id", publish_class_id_);
+    batched_cloud_writer_ = PointCloud2Writer(true, publish_class_id_);
+    get_parameter("use_loaned_messages", use_loaned_messages_);
+    bool shared_worker_pool;
+    get_parameter("shared_worker_pool", shared_worker_pool);
+    get_parameter("realtime", realtime_);
+    get_parameter("realtime_priority", realtime_priority_);
+    get_parameter("realtime_cpus", realtime_cpus_);
+    int max_points, max_boxes, max_object_points;
+    get_parameter("max_points", max_points);
+    get_parameter("max_boxes", max_boxes);
+    get_parameter("max_object_points", max_object_points);
+    get_parameter("transform_refresh_period", transform_refresh_period_);
+    get_parameter("adaptive_decimation", adaptive_decimation_);
+    double decimation_latency_budget;
+    int decimation_window, max_decimation_stride;
+    get_parameter("decimation_latency_budget", decimation_latency_budget);
+    get_parameter("decimation_window", decimation_window);
+    get_parameter("max_decimation_stride", max_decimation_stride);
+    get_parameter("pipeline", pipeline_);
+    get_parameter("pipeline_depth", pipeline_depth_);
+    get_parameter("latency_budget", latency_budget_);
+    get_parameter("late_frame_policy", late_frame_policy_);
+    get_parameter("executor", executor_);
+    get_parameter("executor_threads", executor_threads_);
+    get_parameter("metrics_period", metrics_period_);
+    get_parameter("allocation_check_warmup_frames", allocation_check_warmup_frames_);
+    get_parameter("fail_on_steady_state_allocation", fail_on_steady_state_allocation_);
+
+    // Loaned messages cannot be delivered intra-process, so never borrow when it is enabled
+    if (use_loaned_messages_ && use_intra_process_comms_) {
+        RCLCPP_INFO(get_logger(), "Intra-process communication enabled, not using loaned messages");
+        use_loaned_messages_ = false;
+    }
+
+    if (max_points <= 0 || max_boxes <= 0 || max_object_points <= 0) {
+        RCLCPP_WARN(get_logger(), "max_points, max_boxes and max_object_points must be positive, using the defaults");
+        max_points = 131072;
+        max_boxes = 64;
+        max_object_points = 16384;
+    }
+    max_points_ = static_cast<size_t>(max_points);
+    max_boxes_ = static_cast<size_t>(max_boxes);
+    max_object_points_ = static_cast<size_t>(max_object_points);
+    const int min_priority = sched_get_priority_min(SCHED_FIFO);
+    const int max_priority = sched_get_priority_max(SCHED_FIFO);
+    if (realtime_priority_ < min_priority || realtime_priority_ > max_priority) {
+        RCLCPP_WARN(get_logger(), "realtime_priority must be in [%d, %d], clamping", min_priority, max_priority);
+        realtime_priority_ = std::min(std::max(realtime_priority_, min_priority), max_priority);
+    }
+    if (realtime_ && transform_refresh_period_ <= 0.0) {
+        RCLCPP_WARN(get_logger(), "transform_refresh_period must be positive, using 0.1 s");
+        transform_refresh_period_ = 0.1;
+    }
+
+    if (latency_budget_ < 0.0) {
+        RCLCPP_WARN(get_logger(), "latency_budget must not be negative, disabling it");
+        latency_budget_ = 0.0;
+    }
+    if (late_frame_policy_ != "drop" && late_frame_policy_ != "poses_only") {
+        RCLCPP_WARN(get_logger(), "Unknown late_frame_policy '%s', using 'drop'", late_frame_policy_.c_str());
+        late_frame_policy_ = "drop";
+    }
+    if (adaptive_decimation_ && (decimation_latency_budget <= 0.0 || decimation_window <= 0 || max_decimation_stride < 1)) {
+        RCLCPP_WARN(get_logger(), "decimation_latency_budget and decimation_window must be positive and max_decimation_stride at least 1, disabling adaptive decimation");
+        adaptive_decimation_ = false;
+    }
+    if (adaptive_decimation_) {
+        decimation_controller_ = std::make_unique<DecimationController>(
+            decimation_latency_budget, static_cast<size_t>(decimation_window), max_decimation_stride);
+    }
+    if (pipeline_ && pipeline_depth_ < 2) {
+        RCLCPP_WARN(get_logger(), "pipeline_depth must be at least 2, using 2");
+        pipeline_depth_ = 2;
+    }
+
+    if (executor_ != "single_threaded" && executor_ != "multi_threaded") {
+        RCLCPP_WARN(get_logger(), "Unknown executor '%s', using 'multi_threaded'", executor_.c_str());
+        executor_ = "multi_threaded";
+    }
+    if (executor_threads_ < 1) {
+        RCLCPP_WARN(get_logger(), "executor_threads must be positive, using 4");
+        executor_threads_ = 4;
+    }
+
+    // Two workspaces alternate in serial mode; pipelined mode needs one per frame in flight
+    frame_workspaces_.resize(pipeline_ ? static_cast<size_t>(pipeline_depth_) : 2);
+    for (auto& workspace : frame_workspaces_) {
+        workspace.lidars.resize(lidars_.size());
+        for (auto& lidar_frame : workspace.lidars) {
+            lidar_frame.to_camera.resize(cameras_.size());
+        }
+        workspace.cameras.resize(cameras_.size());
+        workspace.lidar_offsets.resize(lidars_.size() + 1);
+    }
+
+    if (allocation_check_warmup_frames_ < 0) {
+        RCLCPP_WARN(get_logger(), "allocation_check_warmup_frames must not be negative, using 0");
+        allocation_check_warmup_frames_ = 0;
+    }
+    if (fail_on_steady_state_allocation_ && !AllocationCounter::enabled()) {
+        RCLCPP_WARN(get_logger(), "fail_on_steady_state_allocation needs the counting allocation functions (standalone executable built with L2I_COUNT_ALLOCATIONS), ignoring it");
+        fail_on_steady_state_allocation_ = false;
+    }
+
+    if (use_depth_histogram_ && depth_histogram_bin_width_ <= 0.0f) {
+        RCLCPP_WARN(get_logger(), "depth_histogram_bin_width must be positive, disabling depth histogram");
+        use_depth_histogram_ = false;
+    }
+    if (association_mode_ != "bbox" && association_mode_ != "mask") {
+        RCLCPP_WARN(get_logger(), "Unknown association_mode '%s', using 'bbox'", association_mode_.c_str());
+        association_mode_ = "bbox";
+    }
+    use_mask_association_ = association_mode_ == "mask";
+    if (use_clustering_ && cluster_tolerance_ <= 0.0f) {
+        RCLCPP_WARN(get_logger(), "cluster_tolerance must be positive, disabling clustering");
+        use_clustering_ = false;
+    }
+    if (cluster_min_points_ < 1) {
+        RCLCPP_WARN(get_logger(), "cluster_min_points must be at least 1, using 1");
+        cluster_min_points_ = 1;
+    }
+    if (cluster_selection_ != "largest" && cluster_selection_ != "nearest") {
+        RCLCPP_WARN(get_logger(), "Unknown cluster_selection '%s', using 'largest'", cluster_selection_.c_str());
+        cluster_selection_ = "largest";
+    }
+
+    // Real-time mode gives the workers SCHED_FIFO priority and CPU affinity, which must not
+    // leak onto the threads of other nodes in the process
+    if (realtime_ && shared_worker_pool) {
+        RCLCPP_WARN(get_logger(), "realtime reschedules the worker threads, using a private worker pool instead of the shared one");
+        shared_worker_pool = false;
+    }
 
-        get_parameter("lidar_frame", lidar_frame_);
-        get_parameter("camera_frame", camera_frame_);
-        get_parameter("min_range", min_range_);
-        get_parameter("max_range", max_range_);
+    // Worker threads are started once and reused by every parallel stage of every frame; fusion
+    // nodes composed into one process share them, so idle threads serve whichever stream is busy
+    worker_pool_ = shared_worker_pool
+        ? sharedWorkerPool()
+        : std::make_shared<WorkerPool>(std::max(1u, std::thread::hardware_concurrency()), &trackWorkerThread);
+    num_threads_ = worker_pool_->size();
+
+    // One clustering workspace per worker thread, reused across frames
+    cluster_workspaces_.resize(num_threads_);
+    cluster_indices_.resize(num_threads_);
+    downsampling_workspaces_.resize(num_threads_);
+    association_slices_.resize(num_threads_);
+
+    // Ground segmentation runs on at most this many sampled points for unorganized clouds
+    if (use_ground_removal) {
+        ground_segmentation_ = std::make_unique<GroundSegmentation>(
+            ground_max_slope, ground_distance_threshold, ground_ransac_iterations, 2000);
+    }
+
+    RCLCPP_INFO(
+        get_logger(),
+        "Parameters: lidar_frame='%s', camera_frame='%s', min_range=%.2f, max_range=%.2f",
+        lidar_frame_.c_str(),
+        camera_frame_.c_str(),
+        min_range_,
+        max_range_
+    );
+    RCLCPP_INFO(get_logger(), "Cameras: %zu, sync_tolerance=%.3f s", cameras_.size(), camera_sync_tolerance_);
+    RCLCPP_INFO(get_logger(), "Lidars: %zu, sync_tolerance=%.3f s", lidars_.size(), lidar_sync_tolerance_);
+    RCLCPP_INFO(
+        get_logger(),
+        "Depth histogram: enabled=%s, bin_width=%.2f, peak_ratio=%.2f",
+        use_depth_histogram_ ? "true" : "false",
+        depth_histogram_bin_width_,
+        depth_histogram_peak_ratio_
+    );
+    RCLCPP_INFO(get_logger(), "Association mode: %s", association_mode_.c_str());
+    RCLCPP_INFO(get_logger(), "Lens distortion: %s", use_distortion_ ? "applied (raw image)" : "ignored (rectified image)");
+    RCLCPP_INFO(
+        get_logger(),
+        "Clustering: enabled=%s, tolerance=%.2f, min_points=%d, selection=%s",
+        use_clustering_ ? "true" : "false",
+        cluster_tolerance_,
+        cluster_min_points_,
+        cluster_selection_.c_str()
+    );
+    RCLCPP_INFO(
+        get_logger(),
+        "Ground removal: enabled=%s, max_slope=%.1f deg, distance_threshold=%.2f, ransac_iterations=%d",
+        use_ground_removal ? "true" : "false",
+        ground_max_slope,
+        ground_distance_threshold,
+        ground_ransac_iterations
+    );
+    RCLCPP_INFO(get_logger(), "Object cloud leaf size: %.3f (0 disables downsampling)", object_cloud_leaf_size_);
+    RCLCPP_INFO(
+        get_logger(),
+        "Object clouds: batched=%s, class_id field=%s",
+        batch_object_clouds_ ? "true" : "false",
+        publish_class_id_ ? "true" : "false"
+    );
+    RCLCPP_INFO(get_logger(), "Loaned messages: %s", use_loaned_messages_ ? "when supported by the RMW (never for unbounded types such as Image and PointCloud2 on Humble)" : "disabled");
+    RCLCPP_INFO(get_logger(), "Worker pool: %zu threads, %s", num_threads_, shared_worker_pool ? "shared within the process" : "private");
+    RCLCPP_INFO(
+        get_logger(),
+        "Real-time mode: enabled=%s, priority=%d, cpus=%zu, max_points=%zu, max_boxes=%zu, max_object_points=%zu, transform_refresh_period=%.2f s",
+        realtime_ ? "true" : "false",
+        realtime_priority_,
+        realtime_cpus_.size(),
+        max_points_,
+        max_boxes_,
+        max_object_points_,
+        transform_refresh_period_
+    );
+    RCLCPP_INFO(
+        get_logger(),
+        "Latency budget: %.3f s (0 disables), late_frame_policy=%s",
+        latency_budget_,
+        late_frame_policy_.c_str()
+    );
+    RCLCPP_INFO(
+        get_logger(),
+        "Adaptive decimation: enabled=%s, latency_budget=%.3f s, window=%d, max_stride=%d",
+        adaptive_decimation_ ? "true" : "false",
+        decimation_latency_budget,
+        decimation_window,
+        max_decimation_stride
+    );
+    RCLCPP_INFO(get_logger(), "Pipeline: enabled=%s, depth=%d", pipeline_ ? "true" : "false", pipeline_depth_);
+    RCLCPP_INFO(get_logger(), "Executor: %s, threads=%d (standalone node only)", executor_.c_str(), executor_threads_);
+    RCLCPP_INFO(
+        get_logger(),
+        "Metrics: period=%.2f s, allocation counting=%s, warmup_frames=%d, fail_on_steady_state_allocation=%s",
+        metrics_period_,
+        AllocationCounter::enabled() ? "enabled" : "disabled",
+        allocation_check_warmup_frames_,
+        fail_on_steady_state_allocation_ ? "true" : "false"
+    );
+}
+
+// Read the camera list and the per-camera topics and frames
+void LidarCameraFusionNode::declare_cameras()
+{
+    declare_parameter<std::vector<std::string>>("cameras", std::vector<std::string>{});
+    declare_parameter<double>("camera_sync_tolerance", 0.05);
+    std::vector<std::string> camera_names;
+    get_parameter("cameras", camera_names);
+    get_parameter("camera_sync_tolerance", camera_sync_tolerance_);
+    if (camera_sync_tolerance_ < 0.0) {
+        RCLCPP_WARN(get_logger(), "camera_sync_tolerance must not be negative, using 0.05 s");
+        camera_sync_tolerance_ = 0.05;
+    }
+
+    // Without a camera list the node keeps its original single-camera topics
+    if (camera_names.empty()) {
+        auto camera = std::make_unique<Camera>();
+        camera->camera_frame = camera_frame_;
+        camera->image_topic = "/observer/gimbal_camera";
+        camera->camera_info_topic = "/observer/gimbal_camera_info";
+        camera->detection_topic = "/rgb/tracking";
+        camera->fused_image_topic = "/image_lidar_fusion";
+        camera->pose_topic = "/detected_object_pose";
+        camera->object_cloud_topic = "/detected_object_point_cloud";
+        cameras_.push_back(std::move(camera));
+        return;
+    }
+
+    for (const auto& name : camera_names) {
+        const bool duplicate = std::any_of(cameras_.begin(), cameras_.end(),
+                                           [&name](const std::unique_ptr<Camera>& camera) { return camera->name == name; });
+        if (name.empty() || duplicate) {
+            RCLCPP_WARN(get_logger(), "Ignoring empty or duplicate camera name '%s'", name.c_str());
+            continue;
+        }
+
+        // Topics and frame default to names derived from the camera name
+        auto camera = std::make_unique<Camera>();
+        camera->name = name;
+        declare_parameter<std::string>(name + ".camera_frame", name);
+        declare_parameter<std::string>(name + ".image_topic", "/" + name + "/image");
+        declare_parameter<std::string>(name + ".camera_info_topic", "/" + name + "/camera_info");
+        declare_parameter<std::string>(name + ".detection_topic", "/" + name + "/detections");
+        get_parameter(name + ".camera_frame", camera->camera_frame);
+        get_parameter(name + ".image_topic", camera->image_topic);
+        get_parameter(name + ".camera_info_topic", camera->camera_info_topic);
+        get_parameter(name + ".detection_topic", camera->detection_topic);
+        camera->fused_image_topic = "/" + name + "/image_lidar_fusion";
+        camera->pose_topic = "/" + name + "/detected_object_pose";
+        camera->object_cloud_topic = "/" + name + "/detected_object_point_cloud";
+        camera->recent_pairs.resize(10);  // As deep as the synchronizer queues
 
         RCLCPP_INFO(
             get_logger(),
-            "Parameters: lidar_frame='%s', camera_frame='%s', min_range=%.2f, max_range=%.2f",
-            lidar_frame_.c_str(),
-            camera_frame_.c_str(),
-            min_range_,
-            max_range_
+            "Camera '%s': frame='%s', image='%s', camera_info='%s', detections='%s'",
+            name.c_str(),
+            camera->camera_frame.c_str(),
+            camera->image_topic.c_str(),
+            camera->camera_info_topic.c_str(),
+            camera->detection_topic.c_str()
         );
+        cameras_.push_back(std::move(camera));
     }
+}
 
-    // Initialize subscribers and publishers
-    void initialize_subscribers_and_publishers()
-    {
-        // Subscribers for point cloud, image, and detections
-        point_cloud_sub_.subscribe(this, "/scan/points");
-        image_sub_.subscribe(this, "/observer/gimbal_camera");
-        detection_sub_.subscribe(this, "/rgb/tracking");
-        camera_info_sub_ = create_subscription<sensor_msgs::msg::CameraInfo>(
-            "/observer/gimbal_camera_info", 10, std::bind(&LidarCameraFusionNode::camera_info_callback, this, std::placeholders::_1));
-
-        // Synchronizer to align point cloud, image, and detection messages
-        using SyncPolicy = message_filters::sync_policies::ApproximateTime<
-            sensor_msgs::msg::PointCloud2, sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>;
-        sync_ = std::make_shared<message_filters::Synchronizer<SyncPolicy>>(SyncPolicy(10), point_cloud_sub_, image_sub_, detection_sub_);
-        sync_->registerCallback(std::bind(&LidarCameraFusionNode::sync_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+// Read the lidar list and the per-lidar topics and frames
+void LidarCameraFusionNode::declare_lidars()
+{
+    declare_parameter<std::vector<std::string>>("lidars", std::vector<std::string>{});
+    declare_parameter<double>("lidar_sync_tolerance", 0.05);
+    std::vector<std::string> lidar_names;
+    get_parameter("lidars", lidar_names);
+    get_parameter("lidar_sync_tolerance", lidar_sync_tolerance_);
+    if (lidar_sync_tolerance_ < 0.0) {
+        RCLCPP_WARN(get_logger(), "lidar_sync_tolerance must not be negative, using 0.05 s");
+        lidar_sync_tolerance_ = 0.05;
+    }
+
+    // Without a lidar list the node keeps its original single-lidar topic
+    if (lidar_names.empty()) {
+        auto lidar = std::make_unique<Lidar>();
+        lidar->lidar_frame = lidar_frame_;
+        lidar->topic = "/scan/points";
+        lidars_.push_back(std::move(lidar));
+        return;
+    }
+
+    for (const auto& name : lidar_names) {
+        const bool duplicate = std::any_of(lidars_.begin(), lidars_.end(),
+                                           [&name](const std::unique_ptr<Lidar>& lidar) { return lidar->name == name; });
+        if (name.empty() || duplicate) {
+            RCLCPP_WARN(get_logger(), "Ignoring empty or duplicate lidar name '%s'", name.c_str());
+            continue;
+        }
+
+        // Topic and frame default to names derived from the lidar name
+        auto lidar = std::make_unique<Lidar>();
+        lidar->name = name;
+        declare_parameter<std::string>(name + ".lidar_frame", name);
+        declare_parameter<std::string>(name + ".topic", "/" + name + "/points");
+        get_parameter(name + ".lidar_frame", lidar->lidar_frame);
+        get_parameter(name + ".topic", lidar->topic);
+        lidar->recent_scans.resize(10);  // As deep as the synchronizer queues
+
+        RCLCPP_INFO(get_logger(), "Lidar '%s': frame='%s', topic='%s'", name.c_str(), lidar->lidar_frame.c_str(), lidar->topic.c_str());
+        lidars_.push_back(std::move(lidar));
+    }
+}
+
+// Initialize subscribers and publishers
+void LidarCameraFusionNode::initialize_subscribers_and_publishers()
+{
+    // Each group runs one callback at a time, but the groups run concurrently on a
+    // multi-threaded executor: a frame being processed on the synchronized inputs does not
+    // hold up camera_info, the secondary inputs or the timers
+    sync_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    buffer_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    camera_info_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    timer_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    rclcpp::SubscriptionOptions sync_options, buffer_options, camera_info_options;
+    sync_options.callback_group = sync_callback_group_;
+    buffer_options.callback_group = buffer_callback_group_;
+    camera_info_options.callback_group = camera_info_callback_group_;
+
+    // Subscribers for the primary lidar's point cloud, and image and detections of the primary camera
+    Camera& primary = *cameras_.front();
+    point_cloud_sub_.subscribe(this, lidars_.front()->topic, rmw_qos_profile_default, sync_options);
+    image_sub_.subscribe(this, primary.image_topic, rmw_qos_profile_default, sync_options);
+    detection_sub_.subscribe(this, primary.detection_topic, rmw_qos_profile_default, sync_options);
+
+    // Synchronizer to align point cloud, image, and detection messages
+    using SyncPolicy = message_filters::sync_policies::ApproximateTime<
+        sensor_msgs::msg::PointCloud2, sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>;
+    sync_ = std::make_shared<message_filters::Synchronizer<SyncPolicy>>(SyncPolicy(10), point_cloud_sub_, image_sub_, detection_sub_);
+    sync_->registerCallback(std::bind(&LidarCameraFusionNode::sync_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+    // Secondary cameras pair their own images and detections, which are matched to scans by stamp
+    using PairPolicy = message_filters::sync_policies::ApproximateTime<sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>;
+    for (size_t c = 1; c < cameras_.size(); ++c) {
+        Camera& camera = *cameras_[c];
+        camera.image_sub.subscribe(this, camera.image_topic, rmw_qos_profile_default, buffer_options);
+        camera.detection_sub.subscribe(this, camera.detection_topic, rmw_qos_profile_default, buffer_options);
+        camera.pair_sync = std::make_shared<message_filters::Synchronizer<PairPolicy>>(PairPolicy(10), camera.image_sub, camera.detection_sub);
+        camera.pair_sync->registerCallback(std::bind(&LidarCameraFusionNode::camera_pair_callback, this,
+                                                     std::placeholders::_1, std::placeholders::_2, std::ref(camera)));
+    }
+
+    // Secondary lidars keep their recent scans, which are matched to frames by stamp
+    for (size_t l = 1; l < lidars_.size(); ++l) {
+        Lidar& lidar = *lidars_[l];
+        lidar.point_cloud_sub = create_subscription<sensor_msgs::msg::PointCloud2>(
+            lidar.topic, 10,
+            [this, &lidar](const sensor_msgs::msg::PointCloud2::ConstSharedPtr msg) { lidar_scan_callback(msg, lidar); },
+            buffer_options);
+    }
+
+    for (auto& camera_ptr : cameras_) {
+        Camera& camera = *camera_ptr;
+        camera.camera_info_sub = create_subscription<sensor_msgs::msg::CameraInfo>(
+            camera.camera_info_topic, 10,
+            [this, &camera](const sensor_msgs::msg::CameraInfo::SharedPtr msg) { camera_info_callback(msg, camera); },
+            camera_info_options);
 
         // Publishers for fused image, object poses, and object point clouds
-        image_publisher_ = create_publisher<sensor_msgs::msg::Image>("/image_lidar_fusion", 10);
-        pose_publisher_ = create_publisher<geometry_msgs::msg::PoseArray>("/detected_object_pose", 10);
-        object_point_cloud_publisher_ = create_publisher<sensor_msgs::msg::PointCloud2>("/detected_object_point_cloud", 10);
+        camera.image_publisher = create_publisher<sensor_msgs::msg::Image>(camera.fused_image_topic, 10);
+        camera.pose_publisher = create_publisher<geometry_msgs::msg::PoseArray>(camera.pose_topic, 10);
+        camera.object_point_cloud_publisher = create_publisher<sensor_msgs::msg::PointCloud2>(camera.object_cloud_topic, 10);
     }
 
-    // Callback for camera info to initialize the camera model
-    void camera_info_callback(const sensor_msgs::msg::CameraInfo::SharedPtr msg)
-    {
-        camera_model_.fromCameraInfo(msg);  // Load camera intrinsics
-        image_width_ = msg->width;  // Store image width
-        image_height_ = msg->height;  // Store image height
+    // In real-time mode the extrinsics are looked up here, never on the processing thread
+    if (realtime_) {
+        extrinsics_timer_ = create_wall_timer(
+            std::chrono::duration<double>(transform_refresh_period_), std::bind(&LidarCameraFusionNode::refreshExtrinsics, this),
+            timer_callback_group_);
+    }
+
+    // Periodic metrics on the standard diagnostics topic
+    if (metrics_period_ > 0.0) {
+        metrics_publisher_ = create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+        metrics_timer_ = create_wall_timer(
+            std::chrono::duration<double>(metrics_period_), std::bind(&LidarCameraFusionNode::publishMetrics, this),
+            timer_callback_group_);
+    }
+}
+
+// Callback for camera info to initialize the camera model
+void LidarCameraFusionNode::camera_info_callback(const sensor_msgs::msg::CameraInfo::SharedPtr msg, Camera& camera)
+{
+    // CameraInfo is republished with every image, but rarely changes: the model and its
+    // tables are only rebuilt when it does
+    const auto current = camera.calibration.load();
+    if (current && current->projection.sameCalibration(*msg, use_distortion_)) return;
+
+    // Set up the new snapshot aside and publish it in one step; frames being projected keep
+    // the snapshot they loaded
+    auto calibration = std::make_shared<Calibration>();
+    calibration->projection.fromCameraInfo(*msg, use_distortion_);
+    calibration->image_width = msg->width;  // Store image width
+    calibration->image_height = msg->height;  // Store image height
+    camera.calibration.store(std::move(calibration));
+    RCLCPP_INFO(get_logger(), "Camera model for '%s' built from '%s' calibration",
+                camera.camera_frame.c_str(), msg->distortion_model.c_str());
+}
+
+// Keep a synchronized image/detection pair of a secondary camera, replacing the oldest one
+void LidarCameraFusionNode::camera_pair_callback(const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                                                 const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg,
+                                                 Camera& camera)
+{
+    // The replaced pair is released after unlocking, so the lock is only held for the swap
+    auto pair = std::make_pair(image_msg, detection_msg);
+    std::lock_guard<PriorityInheritanceMutex> lock(camera.pairs_mutex);
+    std::swap(camera.recent_pairs[camera.next_pair], pair);
+    camera.next_pair = (camera.next_pair + 1) % camera.recent_pairs.size();
+}
+
+// Keep a scan of a secondary lidar, replacing the oldest one
+void LidarCameraFusionNode::lidar_scan_callback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg, Lidar& lidar)
+{
+    // The replaced scan is released after unlocking, so the lock is only held for the swap
+    auto scan = point_cloud_msg;
+    std::lock_guard<PriorityInheritanceMutex> lock(lidar.scans_mutex);
+    std::swap(lidar.recent_scans[lidar.next_scan], scan);
+    lidar.next_scan = (lidar.next_scan + 1) % lidar.recent_scans.size();
+}
+
+// Attach the synchronized inputs, the closest scan of every secondary lidar and the closest
+// pair of every secondary camera to a frame
+void LidarCameraFusionNode::assignFrameInputs(FrameWorkspace& workspace,
+                                              const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                                              const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                                              const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg)
+{
+    workspace.lidars[0].point_cloud_msg = point_cloud_msg;
+    workspace.cameras[0].image_msg = image_msg;
+    workspace.cameras[0].detection_msg = detection_msg;
+
+    // A secondary lidar without a scan within the tolerance sits this frame out; each scan
+    // keeps its own stamp for the transform lookups
+    const rclcpp::Time cloud_time(point_cloud_msg->header.stamp);
+    for (size_t l = 1; l < lidars_.size(); ++l) {
+        Lidar& lidar = *lidars_[l];
+        LidarFrame& lidar_frame = workspace.lidars[l];
+        lidar_frame.point_cloud_msg.reset();
+        double best_offset = lidar_sync_tolerance_;
+        std::lock_guard<PriorityInheritanceMutex> lock(lidar.scans_mutex);
+        for (const auto& scan : lidar.recent_scans) {
+            if (!scan) continue;
+            const double offset = std::abs((rclcpp::Time(scan->header.stamp) - cloud_time).seconds());
+            if (offset <= best_offset) {
+                best_offset = offset;
+                lidar_frame.point_cloud_msg = scan;
+            }
+        }
+    }
+
+    // A secondary camera without a pair within the tolerance sits this frame out
+    for (size_t c = 1; c < cameras_.size(); ++c) {
+        Camera& camera = *cameras_[c];
+        CameraFrame& camera_frame = workspace.cameras[c];
+        camera_frame.image_msg.reset();
+        camera_frame.detection_msg.reset();
+        double best_offset = camera_sync_tolerance_;
+        std::lock_guard<PriorityInheritanceMutex> lock(camera.pairs_mutex);
+        for (const auto& pair : camera.recent_pairs) {
+            if (!pair.first) continue;
+            const double offset = std::abs((rclcpp::Time(pair.first->header.stamp) - cloud_time).seconds());
+            if (offset <= best_offset) {
+                best_offset = offset;
+                camera_frame.image_msg = pair.first;
+                camera_frame.detection_msg = pair.second;
+            }
+        }
+    }
+}
+
+// Synchronized callback for point cloud, image, and detections
+void LidarCameraFusionNode::sync_callback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                                          const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                                          const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg)
+{
+    // Pipelined mode: start the frame in a free workspace, or drop it when all are in flight
+    if (pipeline_) {
+        FrameWorkspace* workspace;
+        if (!free_workspaces_->tryPop(workspace)) {
+            pipeline_full_frames_++;
+            return;
+        }
+        assignFrameInputs(*workspace, point_cloud_msg, image_msg, detection_msg);
+        workspace->skipped = false;
+        workspace->allocations = 0;
+        workspace->processing_time = 0.0;
+        stage_queues_[0]->push(workspace);
+        return;
+    }
+
+    if (!realtime_) {
+        processFrame(point_cloud_msg, image_msg, detection_msg);
+        return;
     }
 
-    // Synchronized callback for point cloud, image, and detections
-    void sync_callback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
-                       const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
-                       const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg)
+    // Hand the frame to the real-time thread; a frame it has not picked up yet is replaced,
+    // and released after unlocking
+    auto point_cloud = point_cloud_msg;
+    auto image = image_msg;
+    auto detections = detection_msg;
+    bool wake;
     {
-        // Process point cloud: crop, transform to camera frame
-        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_camera_frame = processPointCloud(point_cloud_msg);
+        std::lock_guard<PriorityInheritanceMutex> lock(realtime_mutex_);
+        wake = pending_point_cloud_ == nullptr;
+        if (!wake) superseded_frames_++;
+        pending_point_cloud_.swap(point_cloud);
+        pending_image_.swap(image);
+        pending_detections_.swap(detections);
+    }
+    if (wake) realtime_wakeup_.post();
+}
+
+// Run the fusion pipeline on one synchronized frame
+void LidarCameraFusionNode::processFrame(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                                         const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
+                                         const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg)
+{
+    // Alternate between the frame workspaces; all per-frame buffers live there. In real-time
+    // mode a workspace is in use until the publish thread releases it, and a frame that finds
+    // none free is dropped rather than waited for.
+    FrameWorkspace* free_workspace = nullptr;
+    if (realtime_) {
+        if (!free_workspaces_->tryPop(free_workspace)) {
+            pipeline_full_frames_++;
+            return;
+        }
+    } else {
+        free_workspace = &frame_workspaces_[frame_index_++ % frame_workspaces_.size()];
+    }
+    FrameWorkspace& workspace = *free_workspace;
+    assignFrameInputs(workspace, point_cloud_msg, image_msg, detection_msg);
+    workspace.skipped = false;
+    workspace.allocations = 0;
+    workspace.processing_time = 0.0;
+
+    // Count the allocations made by this frame on this thread and the worker threads
+    ScopedAllocationTracking allocation_tracking;
+    runFusionStage(&LidarCameraFusionNode::ingestFrame, workspace);
+    if (!workspace.skipped) {
+        runFusionStage(&LidarCameraFusionNode::associateFrame, workspace);
+        runFusionStage(&LidarCameraFusionNode::estimateFramePoses, workspace);
+    }
+
+    // Serializing and publishing goes through the middleware, which locks and allocates: the
+    // real-time thread leaves it to the publish thread
+    if (realtime_) {
+        stage_queues_[3]->push(&workspace);
+        return;
+    }
+    publishFrame(workspace);
+}
+
+// Decode, crop and transform the cloud and read the detections
+void LidarCameraFusionNode::ingestFrame(FrameWorkspace& workspace)
+{
+    // Decimation chosen by the latency controller, applied while decoding
+    const auto& point_cloud_msg = workspace.lidars[0].point_cloud_msg;
+    workspace.decimation_stride = decimation_controller_ ? static_cast<uint32_t>(decimation_controller_->stride()) : 1;
+
+    // Real-time mode never grows the workspaces past the declared maximum
+    for (const auto& lidar_frame : workspace.lidars) {
+        const auto& msg = lidar_frame.point_cloud_msg;
+        if (!realtime_ || !msg) continue;
+        const size_t decoded_points = static_cast<size_t>(msg->height) *
+            ((msg->width + workspace.decimation_stride - 1) / workspace.decimation_stride);
+        if (decoded_points > max_points_) {
+            workspace.skipped = true;
+            oversized_frames_++;
+            RCLCPP_ERROR_THROTTLE(get_logger(), *get_clock(), 5000, "Point cloud exceeds max_points (%zu), frame skipped", max_points_);
+            return;
+        }
+    }
+
+    // A fresh answer beats a complete stale one: frames already older than the budget
+    // are dropped, or only get their poses computed and published
+    workspace.poses_only = false;
+    if (latency_budget_ > 0.0 && (now() - rclcpp::Time(point_cloud_msg->header.stamp)).seconds() > latency_budget_) {
+        if (late_frame_policy_ == "drop") {
+            late_dropped_frames_++;
+            workspace.skipped = true;
+            return;
+        }
+        late_pose_only_frames_++;
+        workspace.poses_only = true;
+    }
+
+    // Process point clouds: decode and crop each scan once, in its lidar frame, for all
+    // cameras, and resolve its transform into each camera at its own stamp
+    for (size_t l = 0; l < lidars_.size(); ++l) {
+        LidarFrame& lidar_frame = workspace.lidars[l];
+        if (!lidar_frame.point_cloud_msg) {
+            lidar_frame.cloud->clear();  // No scan of this lidar matched the frame
+            continue;
+        }
+        processPointCloud(*lidars_[l], lidar_frame.point_cloud_msg, workspace.decimation_stride, *lidar_frame.cloud);
+        for (size_t c = 0; c < cameras_.size(); ++c) {
+            if (!workspace.cameras[c].detection_msg) continue;
+            resolveCameraTransform(*cameras_[c], l, lidar_frame.point_cloud_msg->header, lidar_frame.to_camera[c]);
+        }
+    }
+
+    // Extract the bounding boxes of each camera, and take the calibration the frame is
+    // projected with; a camera_info update from here on only affects the next frame
+    for (size_t c = 0; c < cameras_.size(); ++c) {
+        CameraFrame& camera_frame = workspace.cameras[c];
+        if (!camera_frame.detection_msg) continue;  // No image of this camera matched the scan
+        camera_frame.calibration = cameras_[c]->calibration.load();
+        if (!camera_frame.calibration) {
+            RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "No camera_info received for '%s' yet, points not projected",
+                                 cameras_[c]->camera_frame.c_str());
+        }
+        processDetections(camera_frame.detection_msg, camera_frame);
+    }
+}
 
-        // Process detections: extract bounding boxes
-        std::vector<BoundingBox> bounding_boxes = processDetections(detection_msg);
+// Project the clouds into every camera and associate points with detections
+void LidarCameraFusionNode::associateFrame(FrameWorkspace& workspace)
+{
+    projectPointsAndAssociateWithBoundingBoxes(workspace);
+}
 
-        // Project 3D points to 2D image space and associate with bounding boxes
-        std::vector<cv::Point2d> projected_points = projectPointsAndAssociateWithBoundingBoxes(cloud_camera_frame, bounding_boxes);
+// Cluster the object clouds, compute the poses and downsample for publishing
+void LidarCameraFusionNode::estimateFramePoses(FrameWorkspace& workspace)
+{
+    for (size_t c = 0; c < cameras_.size(); ++c) {
+        CameraFrame& camera_frame = workspace.cameras[c];
+        if (!camera_frame.detection_msg) continue;
+
+        // Reduce each object cloud to its selected cluster
+        if (use_clustering_) {
+            clusterObjectClouds(camera_frame.bounding_boxes);
+        }
 
         // Calculate object poses in the lidar frame
-        geometry_msgs::msg::PoseArray pose_array = calculateObjectPoses(bounding_boxes, point_cloud_msg->header.stamp);
+        calculateObjectPoses(*cameras_[c], camera_frame.bounding_boxes, workspace.lidars[0].point_cloud_msg->header.stamp, camera_frame.poses);
 
-        // Publish results: fused image, object poses, and object point clouds
-        publishResults(image_msg, projected_points, bounding_boxes, pose_array);
+        // Downsample object clouds before serialization
+        if (object_cloud_leaf_size_ > 0.0f && !workspace.poses_only) {
+            downsampleObjectClouds(camera_frame.bounding_boxes);
+        }
     }
+}
 
-    // Process point cloud: crop and transform to camera frame
-    pcl::PointCloud<pcl::PointXYZ>::Ptr processPointCloud(const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg)
-    {
-        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-        pcl::fromROSMsg(*point_cloud_msg, *cloud);  // Convert ROS message to PCL point cloud
-
-        // Crop point cloud to a defined range
-        pcl::CropBox<pcl::PointXYZ> box_filter;
-        box_filter.setInputCloud(cloud);
-        box_filter.setMin(Eigen::Vector4f(min_range_, -max_range_, -max_range_, 1.0f));
-        box_filter.setMax(Eigen::Vector4f(max_range_, max_range_, max_range_, 1.0f));
-        box_filter.filter(*cloud);
-
-        // Transform point cloud to camera frame using TF2
-        rclcpp::Time cloud_time(point_cloud_msg->header.stamp);
-        if (tf_buffer_.canTransform(camera_frame_, cloud->header.frame_id, cloud_time, tf2::durationFromSec(1.0))) {
-            geometry_msgs::msg::TransformStamped transform = tf_buffer_.lookupTransform(camera_frame_, cloud->header.frame_id, cloud_time, tf2::durationFromSec(1.0));
-            Eigen::Affine3d eigen_transform = tf2::transformToEigen(transform); // Eigen::Affine3d - which is a 4x4 transformation matrix
-            pcl::PointCloud<pcl::PointXYZ>::Ptr transformed_cloud(new pcl::PointCloud<pcl::PointXYZ>);
-            pcl::transformPointCloud(*cloud, *transformed_cloud, eigen_transform);
-            return transformed_cloud;
-        }
-        return cloud;  // Return original cloud if transformation fails
-    }
-
-    // Process detections: extract bounding boxes from YOLO detections
-    std::vector<BoundingBox> processDetections(const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg)
-    {
-        std::vector<BoundingBox> bounding_boxes;
-        for (const auto& detection : detection_msg->detections) {
-            BoundingBox bbox;
-            bbox.x_min = detection.bbox.center.position.x - detection.bbox.size.x / 2.0;
-            bbox.y_min = detection.bbox.center.position.y - detection.bbox.size.y / 2.0;
-            bbox.x_max = detection.bbox.center.position.x + detection.bbox.size.x / 2.0;
-            bbox.y_max = detection.bbox.center.position.y + detection.bbox.size.y / 2.0;
-            bbox.valid = true;
-            try {
-                bbox.id = std::stoi(detection.id);  // Convert detection ID to integer
-            } catch (const std::exception& e) {
-                RCLCPP_ERROR(get_logger(), "Failed to convert detection ID to integer: %s", e.what());
-                continue;
+// Publish the results of a processed frame and release its input messages
+void LidarCameraFusionNode::publishFrame(FrameWorkspace& workspace)
+{
+    if (!workspace.skipped) {
+        // Output messages are counted separately from the fusion path
+        const uint64_t allocations_at_start = AllocationCounter::count();
+
+        // Publish results per camera: fused image, object poses, and object point clouds (late frames: poses only)
+        const rclcpp::Time cloud_time(workspace.lidars[0].point_cloud_msg->header.stamp);
+        for (size_t c = 0; c < cameras_.size(); ++c) {
+            const CameraFrame& camera_frame = workspace.cameras[c];
+            if (!camera_frame.detection_msg) continue;
+            if (workspace.poses_only) {
+                publishPoses(*cameras_[c], camera_frame.poses, cloud_time);
+            } else {
+                publishResults(*cameras_[c], camera_frame, cloud_time);
             }
-            bbox.object_cloud = pcl::PointCloud<pcl::PointXYZ>::Ptr(new pcl::PointCloud<pcl::PointXYZ>);
-            bounding_boxes.push_back(bbox);
         }
-        return bounding_boxes;
+
+        recordFrameMetrics(workspace.allocations, AllocationCounter::count() - allocations_at_start);
+        if (decimation_controller_) {
+            decimation_controller_->record(workspace.processing_time);
+        }
+    }
+    for (auto& lidar_frame : workspace.lidars) {
+        lidar_frame.point_cloud_msg.reset();
     }
+    for (auto& camera_frame : workspace.cameras) {
+        camera_frame.image_msg.reset();
+        camera_frame.detection_msg.reset();
+        camera_frame.calibration.reset();
+    }
+}
 
-    // Project 3D points to 2D image space and associate with bounding boxes
-    std::vector<cv::Point2d> projectPointsAndAssociateWithBoundingBoxes(
-        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_camera_frame,
-        std::vector<BoundingBox>& bounding_boxes)
-    {
-        std::vector<cv::Point2d> projected_points;
-        std::mutex mtx;  // Mutex for thread-safe updates
+// Run a fusion stage and add the allocations it made and its duration to the frame
+void LidarCameraFusionNode::runFusionStage(FrameStage stage, FrameWorkspace& workspace)
+{
+    const uint64_t allocations_at_start = AllocationCounter::count();
+    const auto time_at_start = std::chrono::steady_clock::now();
+    (this->*stage)(workspace);
+    workspace.processing_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - time_at_start).count();
+    workspace.allocations += AllocationCounter::count() - allocations_at_start;
+}
+
+// Process point cloud: decode and crop in the lidar frame
+void LidarCameraFusionNode::processPointCloud(Lidar& lidar, const sensor_msgs::msg::PointCloud2::ConstSharedPtr& point_cloud_msg,
+                                              uint32_t decimation_stride, pcl::PointCloud<pcl::PointXYZ>& cloud)
+{
+    // The decoder is chosen once per stream from its field layout: known driver layouts get a
+    // specialized kernel, others are read at their field offsets
+    if (lidar.point_cloud_reader.selectLayout(*point_cloud_msg)) {
+        RCLCPP_INFO(get_logger(), "Point layout of '%s': %s", lidar.topic.c_str(), lidar.point_cloud_reader.layoutName());
+    }
+
+    // A cloud whose fields or rows overrun its data buffer is dropped rather than read
+    if (!lidar.point_cloud_reader.wellFormed(*point_cloud_msg)) {
+        RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Malformed point cloud on '%s' (fields, rows or data size inconsistent), scan dropped",
+                             lidar.topic.c_str());
+        cloud.clear();
+        return;
+    }
+
+    // Decode into the retained cloud; layouts without float32 x, y, z go through PCL
+    if (!lidar.point_cloud_reader.read(*point_cloud_msg, cloud, decimation_stride)) {
+        pcl::fromROSMsg(*point_cloud_msg, cloud);  // Convert ROS message to PCL point cloud
+        PointCloud2Reader::decimate(cloud, decimation_stride);
+    }
+
+    // Remove ground returns in the lidar frame, before cropping drops the ring structure
+    if (ground_segmentation_) {
+        ground_segmentation_->removeGround(cloud);
+    }
+
+    // Crop point cloud to a defined range, compacting in place (NaN points fail every test)
+    auto& points = cloud.points;
+    size_t kept = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        const auto& point = points[i];
+        if (point.x >= min_range_ && point.x <= max_range_ &&
+            point.y >= -max_range_ && point.y <= max_range_ &&
+            point.z >= -max_range_ && point.z <= max_range_) {
+            points[kept++] = point;
+        }
+    }
+    points.resize(kept);
+    cloud.width = static_cast<uint32_t>(kept);
+    cloud.height = 1;
+    cloud.is_dense = true;
+}
+
+// Resolve the transform from a lidar's cloud frame to a camera frame at the cloud stamp
+void LidarCameraFusionNode::resolveCameraTransform(const Camera& camera, size_t lidar_index, const std_msgs::msg::Header& cloud_header,
+                                                   UnalignedAffine3f& lidar_to_camera)
+{
+    lidar_to_camera.setIdentity();  // Project the untransformed cloud if the transform is unknown
+
+    // Real-time mode interpolates the cached extrinsics instead of waiting on TF
+    if (realtime_) {
+        const auto history = camera.extrinsics.load();
+        if (history) {
+            const double stamp = rclcpp::Time(cloud_header.stamp).seconds();
+            lidar_to_camera = extrinsicsAt(*history, stamp, [lidar_index](const Extrinsics& extrinsics) -> const StampedTransform& {
+                return extrinsics.lidar_to_camera[lidar_index];
+            }).cast<float>();
+        }
+        return;
+    }
+
+    // Look up the transform to the camera frame using TF2
+    rclcpp::Time cloud_time(cloud_header.stamp);
+    if (tf_buffer_.canTransform(camera.camera_frame, cloud_header.frame_id, cloud_time, tf2::durationFromSec(1.0))) {
+        geometry_msgs::msg::TransformStamped transform = tf_buffer_.lookupTransform(camera.camera_frame, cloud_header.frame_id, cloud_time, tf2::durationFromSec(1.0));
+        Eigen::Affine3d eigen_transform = tf2::transformToEigen(transform); // Eigen::Affine3d - which is a 4x4 transformation matrix
+        lidar_to_camera = eigen_transform.cast<float>();
+    }
+}
+
+// Process detections: extract bounding boxes from YOLO detections
+void LidarCameraFusionNode::processDetections(const yolo_msgs::msg::DetectionArray::ConstSharedPtr& detection_msg, CameraFrame& camera_frame)
+{
+    // Return the previous boxes of this camera to the spare list, keeping their buffers
+    auto& bounding_boxes = camera_frame.bounding_boxes;
+    auto& spare_boxes = camera_frame.spare_boxes;
+    while (!bounding_boxes.empty()) {
+        spare_boxes.push_back(std::move(bounding_boxes.back()));
+        bounding_boxes.pop_back();
+    }
+
+    for (const auto& detection : detection_msg->detections) {
+        // Convert detection ID to integer; strtol neither throws nor allocates (the ID is
+        // empty when the detector runs without tracking)
+        const char* id_text = detection.id.c_str();
+        char* id_end = nullptr;
+        errno = 0;
+        const long parsed_id = std::strtol(id_text, &id_end, 10);
+        if (id_end == id_text || errno == ERANGE || parsed_id < std::numeric_limits<int>::min() ||
+            parsed_id > std::numeric_limits<int>::max()) {
+            RCLCPP_ERROR_THROTTLE(get_logger(), *get_clock(), 5000, "Failed to convert detection ID '%s' to integer", id_text);
+            continue;
+        }
+        const int id = static_cast<int>(parsed_id);
 
-        // Precompute image adjustments
-        const int image_width = image_width_;
-        const int image_height = image_height_;
+        // Detections beyond the declared maximum are dropped in real-time mode
+        if (realtime_ && bounding_boxes.size() >= max_boxes_) {
+            RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "More than max_boxes (%zu) detections, ignoring the rest", max_boxes_);
+            break;
+        }
 
-        // Function to process a subset of points
-        auto process_points = [&](size_t start, size_t end) {
+        // Reuse a spare box when there is one, otherwise this is a new high-water mark
+        if (spare_boxes.empty()) {
+            bounding_boxes.emplace_back();
+            bounding_boxes.back().object_cloud = pcl::PointCloud<pcl::PointXYZ>::Ptr(new pcl::PointCloud<pcl::PointXYZ>);
+        } else {
+            bounding_boxes.push_back(std::move(spare_boxes.back()));
+            spare_boxes.pop_back();
+        }
+        BoundingBox& bbox = bounding_boxes.back();
+        bbox.x_min = detection.bbox.center.position.x - detection.bbox.size.x / 2.0;
+        bbox.y_min = detection.bbox.center.position.y - detection.bbox.size.y / 2.0;
+        bbox.x_max = detection.bbox.center.position.x + detection.bbox.size.x / 2.0;
+        bbox.y_max = detection.bbox.center.position.y + detection.bbox.size.y / 2.0;
+        bbox.sum_x = bbox.sum_y = bbox.sum_z = 0;
+        bbox.count = 0;
+        bbox.valid = true;
+        bbox.id = id;
+        bbox.class_id = detection.class_id;
+        bbox.object_cloud->clear();
+        if (use_depth_histogram_) {
+            // Depth in the camera frame can exceed max_range_ along the crop box diagonal
+            bbox.depth_histogram.reset(depth_histogram_bin_width_, 2.0 * max_range_);
+        }
+        if (use_mask_association_) {
+            // Decode the instance mask once; detections without a mask fall back to the bounding box
+            bbox.mask.decode(detection.mask, bbox.x_min, bbox.y_min, bbox.x_max, bbox.y_max);
+        }
+    }
+}
+
+// Project the 3D points of every lidar to 2D image space of every camera and associate with bounding boxes
+void LidarCameraFusionNode::projectPointsAndAssociateWithBoundingBoxes(FrameWorkspace& workspace)
+{
+    auto& camera_frames = workspace.cameras;
+    for (auto& camera_frame : camera_frames) {
+        camera_frame.projected_points.clear();  // Keeps the capacity of earlier frames
+    }
+    const size_t num_cameras = cameras_.size();
+
+    // The lidar clouds are indexed as one merged scan, so the work is split across threads
+    // without concatenating them
+    const auto& lidar_frames = workspace.lidars;
+    auto& offsets = workspace.lidar_offsets;
+    offsets[0] = 0;
+    for (size_t l = 0; l < lidar_frames.size(); ++l) {
+        offsets[l + 1] = offsets[l] + lidar_frames[l].cloud->points.size();
+    }
+    const size_t num_points = offsets.back();
+    const size_t num_slices = association_slices_.size();
+
+    // Process slices of the merged scan: each lidar point is read once and projected into
+    // every camera that has a frame to fuse. Associations go to the slice's own list, so the
+    // threads share no state and take no lock.
+    auto process_slices = [&](size_t /*thread*/, size_t first_slice, size_t last_slice) {
+        for (size_t s = first_slice; s < last_slice; ++s) {
+            auto& associations = association_slices_[s];
+            associations.clear();  // Keeps the capacity of earlier frames
+            const size_t start = s * num_points / num_slices;
+            const size_t end = (s + 1) * num_points / num_slices;
+            if (start == end) continue;
+            size_t l = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), start) - offsets.begin()) - 1;
             for (size_t i = start; i < end; ++i) {
-                const auto& point = cloud_camera_frame->points[i];
-
-                // Skip points behind the camera (z <= 0)
-                if (point.z <= 0) continue;
-
-                // Project the 3D point into 2D image space
-                cv::Point3d pt_cv(point.x, point.y, point.z);  // 3D point in camera frame (meters)
-                cv::Point2d uv = camera_model_.project3dToPixel(pt_cv);  // Project to 2D (pixels)
-
-                // Adjust for image coordinate system (if needed)
-                uv.y = image_height - uv.y;  // Flip y-axis if origin is at bottom-left
-                uv.x = image_width - uv.x;   // Flip x-axis if needed
-
-                // Check if the projected point lies within any bounding box
-                for (auto& bbox : bounding_boxes) {
-                    if (uv.x >= bbox.x_min && uv.x <= bbox.x_max &&
-                        uv.y >= bbox.y_min && uv.y <= bbox.y_max) {
-                        // Point lies within the bounding box
-                        std::lock_guard<std::mutex> lock(mtx);  // Ensure thread-safe updates
-                        projected_points.push_back(uv);  // Add projected point to results
-                        bbox.sum_x += point.x;  // Accumulate point coordinates (in meters)
-                        bbox.sum_y += point.y;
-                        bbox.sum_z += point.z;
-                        bbox.count++;  // Increment point count
-                        bbox.object_cloud->points.push_back(point);  // Add point to object cloud
-                        break;  // Early exit: skip remaining bounding boxes for this point
+                while (i >= offsets[l + 1]) ++l;  // Next lidar
+                const LidarFrame& lidar_frame = lidar_frames[l];
+                const auto& lidar_point = lidar_frame.cloud->points[i - offsets[l]];
+                const Eigen::Vector3f point_lidar(lidar_point.x, lidar_point.y, lidar_point.z);
+
+                for (size_t c = 0; c < num_cameras; ++c) {
+                    const CameraFrame& camera_frame = camera_frames[c];
+                    if (!camera_frame.detection_msg || !camera_frame.calibration) continue;
+                    const Calibration& calibration = *camera_frame.calibration;
+
+                    // Transform into the camera frame
+                    const Eigen::Vector3f point_camera = lidar_frame.to_camera[c] * point_lidar;
+
+                    // Project the 3D point into 2D image space, skipping points the camera cannot see
+                    // (behind a pinhole camera, outside a fisheye's field of view)
+                    double u, v;
+                    if (!calibration.projection.project(point_camera.x(), point_camera.y(), point_camera.z(), u, v)) continue;
+
+                    // Adjust for image coordinate system (if needed)
+                    v = calibration.image_height - v;  // Flip y-axis if origin is at bottom-left
+                    u = calibration.image_width - u;   // Flip x-axis if needed
+
+                    // Check if the projected point lies within any bounding box
+                    const auto& bounding_boxes = camera_frame.bounding_boxes;
+                    for (size_t b = 0; b < bounding_boxes.size(); ++b) {
+                        const BoundingBox& bbox = bounding_boxes[b];
+                        if (u >= bbox.x_min && u <= bbox.x_max && v >= bbox.y_min && v <= bbox.y_max) {
+                            // Reject points inside the bounding box but outside the instance mask
+                            if (!bbox.mask.empty() && !bbox.mask.contains(u, v)) continue;
+
+                            // Point lies within the bounding box
+                            associations.push_back(Association{static_cast<uint32_t>(c), static_cast<uint32_t>(b),
+                                                               point_camera.x(), point_camera.y(), point_camera.z(), u, v});
+                            break;  // Early exit: skip remaining bounding boxes for this point
+                        }
                     }
                 }
             }
-        };
+        }
+    };
 
-        // Split the work across multiple threads
-        const size_t num_threads = std::thread::hardware_concurrency();
-        const size_t points_per_thread = cloud_camera_frame->points.size() / num_threads;
-        std::vector<std::thread> threads;
+    // Split the work across the worker threads
+    worker_pool_->parallelFor(num_slices, process_slices);
 
-        for (size_t t = 0; t < num_threads; ++t) {
-            size_t start = t * points_per_thread;
-            size_t end = (t == num_threads - 1) ? cloud_camera_frame->points.size() : start + points_per_thread;
-            threads.emplace_back(process_points, start, end);
+    // Apply the associations to the boxes, in scan order
+    for (const auto& associations : association_slices_) {
+        for (const auto& association : associations) {
+            CameraFrame& camera_frame = camera_frames[association.camera];
+            BoundingBox& bbox = camera_frame.bounding_boxes[association.box];
+            camera_frame.projected_points.emplace_back(association.u, association.v);  // Add projected point to results
+            bbox.sum_x += association.x;  // Accumulate point coordinates (in meters)
+            bbox.sum_y += association.y;
+            bbox.sum_z += association.z;
+            bbox.count++;  // Increment point count
+            if (use_depth_histogram_) {
+                bbox.depth_histogram.add(association.x, association.y, association.z);  // Bin point by depth
+            }
+            if (!realtime_ || bbox.object_cloud->points.size() < max_object_points_) {
+                bbox.object_cloud->points.emplace_back(association.x, association.y, association.z);  // Add point to object cloud
+            }
         }
+    }
+}
 
-        // Wait for all threads to finish
-        for (auto& thread : threads) {
-            thread.join();
-        }
+// Keep only the selected voxel cluster of each object cloud, in parallel across boxes
+void LidarCameraFusionNode::clusterObjectClouds(std::vector<BoundingBox>& bounding_boxes)
+{
+    const auto selection = cluster_selection_ == "nearest"
+        ? VoxelClustering::Selection::Nearest
+        : VoxelClustering::Selection::Largest;
 
-        return projected_points;
-    }
+    auto process_boxes = [&](size_t thread, size_t start, size_t end) {
+        auto& clustering = cluster_workspaces_[thread];
+        auto& indices = cluster_indices_[thread];
+        for (size_t i = start; i < end; ++i) {
+            auto& bbox = bounding_boxes[i];
+            if (bbox.count == 0) continue;
 
+            clustering.extract(*bbox.object_cloud, cluster_tolerance_, cluster_min_points_, selection, indices);
 
-    // Calculate object poses in the lidar frame
-    geometry_msgs::msg::PoseArray calculateObjectPoses(
-        const std::vector<BoundingBox>& bounding_boxes,
-        const rclcpp::Time& cloud_time)
-    {
-        geometry_msgs::msg::PoseArray pose_array;
-        pose_array.header.stamp = cloud_time;
-        pose_array.header.frame_id = lidar_frame_;
+            // Compact the object cloud to the cluster (indices are ascending) and recompute its sums
+            auto& points = bbox.object_cloud->points;
+            bbox.sum_x = bbox.sum_y = bbox.sum_z = 0;
+            for (size_t k = 0; k < indices.size(); ++k) {
+                points[k] = points[indices[k]];
+                bbox.sum_x += points[k].x;
+                bbox.sum_y += points[k].y;
+                bbox.sum_z += points[k].z;
+            }
+            points.resize(indices.size());
+            bbox.count = static_cast<int>(indices.size());
+        }
+    };
+    worker_pool_->parallelFor(bounding_boxes.size(), process_boxes);
+}
 
-        // Look up the transformation from camera to LiDAR frame
+// Replace each object cloud by its voxel centroids, in parallel across boxes
+void LidarCameraFusionNode::downsampleObjectClouds(std::vector<BoundingBox>& bounding_boxes)
+{
+    auto process_boxes = [&](size_t thread, size_t start, size_t end) {
+        auto& downsampling = downsampling_workspaces_[thread];
+        for (size_t i = start; i < end; ++i) {
+            auto& bbox = bounding_boxes[i];
+            if (bbox.count > 0 && bbox.object_cloud) {
+                downsampling.filter(*bbox.object_cloud, object_cloud_leaf_size_);
+            }
+        }
+    };
+    worker_pool_->parallelFor(bounding_boxes.size(), process_boxes);
+}
+
+// Calculate object poses in the lidar frame
+void LidarCameraFusionNode::calculateObjectPoses(
+    const Camera& camera,
+    const std::vector<BoundingBox>& bounding_boxes,
+    const rclcpp::Time& cloud_time,
+    std::vector<geometry_msgs::msg::Pose>& poses)
+{
+    poses.clear();  // Keeps the capacity of earlier frames
+
+    // Look up the transformation from camera to LiDAR frame, or take the cached one in real-time mode
+    Eigen::Affine3d eigen_transform;
+    if (realtime_) {
+        const auto history = camera.extrinsics.load();
+        if (!history) return;  // Publish an empty PoseArray until the extrinsics are known
+        eigen_transform = extrinsicsAt(*history, cloud_time.seconds(), [](const Extrinsics& extrinsics) -> const StampedTransform& {
+            return extrinsics.camera_to_lidar;
+        });
+    } else {
         geometry_msgs::msg::TransformStamped transform;
         try {
-            transform = tf_buffer_.lookupTransform(lidar_frame_, camera_frame_, cloud_time, tf2::durationFromSec(1.0));
+            transform = tf_buffer_.lookupTransform(lidar_frame_, camera.camera_frame, cloud_time, tf2::durationFromSec(1.0));
         } catch (tf2::TransformException& ex) {
             RCLCPP_ERROR(get_logger(), "Failed to lookup transform: %s", ex.what());
-            return pose_array;  // Return empty PoseArray if transformation fails
+            return;  // Publish an empty PoseArray if transformation fails
         }
 
         // Convert the transform to Eigen for faster computation
-        Eigen::Affine3d eigen_transform = tf2::transformToEigen(transform);
+        eigen_transform = tf2::transformToEigen(transform);
+    }
 
-        // Calculate average position for each bounding box and transform to LiDAR frame
-        for (const auto& bbox : bounding_boxes) {
-            if (bbox.count > 0) {
-                double avg_x = bbox.sum_x / bbox.count;
-                double avg_y = bbox.sum_y / bbox.count;
-                double avg_z = bbox.sum_z / bbox.count;
-
-                // Create pose in camera frame
-                Eigen::Vector3d point_camera(avg_x, avg_y, avg_z);
-                Eigen::Vector3d point_lidar = eigen_transform * point_camera;
-
-                // Convert to geometry_msgs::msg::Pose
-                geometry_msgs::msg::Pose pose_lidar;
-                pose_lidar.position.x = point_lidar.x();
-                pose_lidar.position.y = point_lidar.y();
-                pose_lidar.position.z = point_lidar.z();
-                pose_lidar.orientation.w = 1.0;
-                pose_array.poses.push_back(pose_lidar);
+    // Calculate average position for each bounding box and transform to LiDAR frame
+    for (const auto& bbox : bounding_boxes) {
+        if (bbox.count > 0) {
+            double avg_x = bbox.sum_x / bbox.count;
+            double avg_y = bbox.sum_y / bbox.count;
+            double avg_z = bbox.sum_z / bbox.count;
+
+            // Create pose in camera frame
+            Eigen::Vector3d point_camera(avg_x, avg_y, avg_z);
+
+            // Prefer the centroid of the dominant foreground depth mode over the raw mean,
+            // unless the object cloud was already reduced to a single cluster
+            if (use_depth_histogram_ && !use_clustering_) {
+                bbox.depth_histogram.modeCentroid(depth_histogram_peak_ratio_, point_camera);
             }
-        }
+            Eigen::Vector3d point_lidar = eigen_transform * point_camera;
 
-        return pose_array;
+            // Convert to geometry_msgs::msg::Pose
+            geometry_msgs::msg::Pose pose_lidar;
+            pose_lidar.position.x = point_lidar.x();
+            pose_lidar.position.y = point_lidar.y();
+            pose_lidar.position.z = point_lidar.z();
+            pose_lidar.orientation.w = 1.0;
+            poses.push_back(pose_lidar);
+        }
     }
+}
+
+// Publish results: fused image, object poses, and object point clouds
+void LidarCameraFusionNode::publishResults(const Camera& camera, const CameraFrame& camera_frame, const rclcpp::Time& cloud_time)
+{
+    const auto& image_msg = camera_frame.image_msg;
+    const auto& bounding_boxes = camera_frame.bounding_boxes;
+
+    // Publish the fused image: the camera image is converted straight into the outgoing
+    // message buffer and the projected points are drawn there in place
+    publishLoanedOrOwned(*camera.image_publisher, use_loaned_messages_, [&](sensor_msgs::msg::Image& image_out) {
+        image_out.header = image_msg->header;
+        image_out.height = image_msg->height;
+        image_out.width = image_msg->width;
+        image_out.encoding = sensor_msgs::image_encodings::BGR8;
+        image_out.is_bigendian = false;
+        image_out.step = image_msg->width * 3;
+        image_out.data.resize(static_cast<size_t>(image_out.step) * image_out.height);
+        cv::Mat fused_image(image_out.height, image_out.width, CV_8UC3, image_out.data.data(), image_out.step);
+        cv_bridge::toCvShare(image_msg, sensor_msgs::image_encodings::BGR8)->image.copyTo(fused_image);
 
-    // Publish results: fused image, object poses, and object point clouds
-    void publishResults(
-        const sensor_msgs::msg::Image::ConstSharedPtr& image_msg,
-        const std::vector<cv::Point2d>& projected_points,
-        const std::vector<BoundingBox>& bounding_boxes,
-        const geometry_msgs::msg::PoseArray& pose_array)
-    {
         // Draw projected points on the image
-        cv_bridge::CvImagePtr cv_ptr = cv_bridge::toCvCopy(image_msg, sensor_msgs::image_encodings::BGR8);
-        for (const auto& uv : projected_points) {
-            cv::circle(cv_ptr->image, cv::Point(uv.x, uv.y), 5, CV_RGB(255, 0, 0), -1);
+        for (const auto& uv : camera_frame.projected_points) {
+            cv::circle(fused_image, cv::Point(uv.x, uv.y), 5, CV_RGB(255, 0, 0), -1);
         }
+    });
 
-        // Publish the fused image
-        image_publisher_->publish(*cv_ptr->toImageMsg());
+    // Publish object point clouds
+    if (batch_object_clouds_) {
+        publishBatchedObjectClouds(camera, bounding_boxes, image_msg->header);
+    } else {
+        for (const auto& bbox : bounding_boxes) {
+            if (bbox.count > 0 && bbox.object_cloud) {
+                publishLoanedOrOwned(*camera.object_point_cloud_publisher, use_loaned_messages_, [&](sensor_msgs::msg::PointCloud2& object_cloud_msg) {
+                    object_cloud_writer_.begin(object_cloud_msg, bbox.object_cloud->points.size());
+                    object_cloud_writer_.write(bbox.object_cloud->points);
+                    object_cloud_msg.header = image_msg->header;
+                    object_cloud_msg.header.frame_id = camera.camera_frame;
+                });
+            }
+        }
+    }
+
+    // Publish object poses
+    publishPoses(camera, camera_frame.poses, cloud_time);
+}
 
-        // Publish object point clouds
+// Publish the object poses of a frame in the lidar frame
+void LidarCameraFusionNode::publishPoses(const Camera& camera, const std::vector<geometry_msgs::msg::Pose>& poses, const rclcpp::Time& cloud_time)
+{
+    publishLoanedOrOwned(*camera.pose_publisher, use_loaned_messages_, [&](geometry_msgs::msg::PoseArray& pose_array) {
+        pose_array.header.stamp = cloud_time;
+        pose_array.header.frame_id = lidar_frame_;
+        pose_array.poses = poses;
+    });
+}
+
+// Publish all object points of the frame in one cloud, labeled with the detection ID
+// (and optionally the class ID) of the object they belong to
+void LidarCameraFusionNode::publishBatchedObjectClouds(
+    const Camera& camera,
+    const std::vector<BoundingBox>& bounding_boxes,
+    const std_msgs::msg::Header& header)
+{
+    size_t total_points = 0;
+    for (const auto& bbox : bounding_boxes) {
+        if (bbox.count > 0 && bbox.object_cloud) total_points += bbox.object_cloud->points.size();
+    }
+
+    publishLoanedOrOwned(*camera.object_point_cloud_publisher, use_loaned_messages_, [&](sensor_msgs::msg::PointCloud2& object_cloud_msg) {
+        object_cloud_msg.header = header;
+        object_cloud_msg.header.frame_id = camera.camera_frame;
+        batched_cloud_writer_.begin(object_cloud_msg, total_points);
         for (const auto& bbox : bounding_boxes) {
             if (bbox.count > 0 && bbox.object_cloud) {
-                sensor_msgs::msg::PointCloud2 object_cloud_msg;
-                pcl::toROSMsg(*bbox.object_cloud, object_cloud_msg);
-                object_cloud_msg.header = image_msg->header;
-                object_cloud_msg.header.frame_id = camera_frame_;
-                object_point_cloud_publisher_->publish(object_cloud_msg);
+                batched_cloud_writer_.write(bbox.object_cloud->points, bbox.id, bbox.class_id);
             }
         }
+    });
+}
+
+// Reserve every per-frame buffer for max_points points and max_boxes detections
+void LidarCameraFusionNode::preallocateWorkspaces()
+{
+    for (auto& workspace : frame_workspaces_) {
+        for (auto& lidar_frame : workspace.lidars) {
+            lidar_frame.cloud->points.reserve(max_points_);
+        }
+        for (auto& camera_frame : workspace.cameras) {
+            camera_frame.projected_points.reserve(max_points_ * lidars_.size());  // Points of every lidar land here
+            camera_frame.poses.reserve(max_boxes_);
+            camera_frame.bounding_boxes.reserve(max_boxes_);
+            camera_frame.spare_boxes.reserve(max_boxes_);
+            while (camera_frame.spare_boxes.size() < max_boxes_) {
+                BoundingBox bbox;
+                bbox.object_cloud = pcl::PointCloud<pcl::PointXYZ>::Ptr(new pcl::PointCloud<pcl::PointXYZ>);
+                bbox.object_cloud->points.reserve(max_object_points_);
+                if (use_depth_histogram_) {
+                    bbox.depth_histogram.reset(depth_histogram_bin_width_, 2.0 * max_range_);
+                }
+                camera_frame.spare_boxes.push_back(std::move(bbox));
+            }
+        }
+    }
+    // A slice holds at most one association per point and camera
+    const size_t slice_points = max_points_ * lidars_.size() / association_slices_.size() + 1;
+    for (auto& associations : association_slices_) {
+        associations.reserve(slice_points * cameras_.size());
+    }
+    for (size_t t = 0; t < num_threads_; ++t) {
+        cluster_workspaces_[t].reserve(max_object_points_);
+        cluster_indices_[t].reserve(max_object_points_);
+        downsampling_workspaces_[t].reserve(max_object_points_);
+    }
+    if (ground_segmentation_) {
+        ground_segmentation_->reserve(max_points_);
+    }
+}
 
-        // Publish object poses
-        pose_publisher_->publish(pose_array);
+// Lock memory, then start the SCHED_FIFO processing thread and reschedule the workers
+void LidarCameraFusionNode::startRealtimeThread()
+{
+    // Keep all current and future pages resident so the hot path never page-faults to disk
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        RCLCPP_WARN(get_logger(), "mlockall failed (%s), memory is not locked", std::strerror(errno));
     }
 
-    // TF2 buffer and listener for coordinate transformations
-    tf2_ros::Buffer tf_buffer_;
-    tf2_ros::TransformListener tf_listener_;
+    // The fusion stage threads take the place of the single processing thread; the publish
+    // stage (the last thread) goes through the middleware and keeps normal scheduling
+    bool scheduled = true;
+    if (pipeline_) {
+        for (size_t i = 0; i + 1 < pipeline_threads_.size(); ++i) {
+            scheduled = applyRealtimeScheduling(pipeline_threads_[i]) && scheduled;
+        }
+    } else {
+        realtime_thread_ = std::thread(&LidarCameraFusionNode::realtimeLoop, this);
+        scheduled = applyRealtimeScheduling(realtime_thread_);
+    }
+    for (auto& worker : worker_pool_->threads()) {
+        scheduled = applyRealtimeScheduling(worker) && scheduled;
+    }
+    if (!scheduled) {
+        RCLCPP_WARN(get_logger(), "Could not apply SCHED_FIFO priority %d or CPU affinity; check rtprio limits and realtime_cpus",
+                    realtime_priority_);
+    }
+}
 
-    // Camera model for projecting 3D points to 2D image space
-    image_geometry::PinholeCameraModel camera_model_;
+// Give a thread the configured real-time priority and CPU affinity
+bool LidarCameraFusionNode::applyRealtimeScheduling(std::thread& thread)
+{
+    sched_param param{};
+    param.sched_priority = realtime_priority_;
+    bool ok = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param) == 0;
 
-    // Parameters for cropping and coordinate frames
-    float min_range_, max_range_;
-    std::string camera_frame_, lidar_frame_;
-    int image_width_, image_height_;
+    if (!realtime_cpus_.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (const auto cpu : realtime_cpus_) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(static_cast<int>(cpu), &cpus);
+        }
+        ok = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0 && ok;
+    }
+    return ok;
+}
 
-    // Subscribers for point cloud, image, and detections
-    message_filters::Subscriber<sensor_msgs::msg::PointCloud2> point_cloud_sub_;
-    message_filters::Subscriber<sensor_msgs::msg::Image> image_sub_;
-    message_filters::Subscriber<yolo_msgs::msg::DetectionArray> detection_sub_;
-    rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_sub_;
+// Start one thread per pipeline stage, connected by bounded queues
+void LidarCameraFusionNode::startPipeline()
+{
+    // Every queue can hold all workspaces, so a stage never waits to hand a frame on
+    const size_t depth = frame_workspaces_.size();
+    free_workspaces_ = std::make_unique<BoundedQueue<FrameWorkspace*>>(depth);
+    for (auto& queue : stage_queues_) {
+        queue = std::make_unique<BoundedQueue<FrameWorkspace*>>(depth);
+    }
+    for (auto& workspace : frame_workspaces_) {
+        free_workspaces_->push(&workspace);
+    }
 
-    // Synchronizer for aligning messages
-    std::shared_ptr<message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<sensor_msgs::msg::PointCloud2, sensor_msgs::msg::Image, yolo_msgs::msg::DetectionArray>>> sync_;
+    // Each stage is a single thread reading a FIFO, so frames leave in arrival order. Without
+    // pipelining, the real-time thread runs the fusion stages itself and feeds the publish stage.
+    if (pipeline_) {
+        pipeline_threads_.emplace_back(&LidarCameraFusionNode::pipelineStageLoop, this,
+                                       &LidarCameraFusionNode::ingestFrame, true,
+                                       std::ref(*stage_queues_[0]), std::ref(*stage_queues_[1]));
+        pipeline_threads_.emplace_back(&LidarCameraFusionNode::pipelineStageLoop, this,
+                                       &LidarCameraFusionNode::associateFrame, true,
+                                       std::ref(*stage_queues_[1]), std::ref(*stage_queues_[2]));
+        pipeline_threads_.emplace_back(&LidarCameraFusionNode::pipelineStageLoop, this,
+                                       &LidarCameraFusionNode::estimateFramePoses, true,
+                                       std::ref(*stage_queues_[2]), std::ref(*stage_queues_[3]));
+    }
+    pipeline_threads_.emplace_back(&LidarCameraFusionNode::pipelineStageLoop, this,
+                                   &LidarCameraFusionNode::publishFrame, false,
+                                   std::ref(*stage_queues_[3]), std::ref(*free_workspaces_));
+}
 
-    // Publishers for fused image, object poses, and object point clouds
-    rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr image_publisher_;
-    rclcpp::Publisher<geometry_msgs::msg::PoseArray>::SharedPtr pose_publisher_;
-    rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr object_point_cloud_publisher_;
-};
+// Pipeline stage thread: run stage on each frame from input and pass it to output
+void LidarCameraFusionNode::pipelineStageLoop(FrameStage stage, bool fusion_stage,
+                                              BoundedQueue<FrameWorkspace*>& input, BoundedQueue<FrameWorkspace*>& output)
+{
+    // Counts are per thread, so the publish stage is counted apart from the fusion stages
+    AllocationCounter::trackCurrentThread(true);
+
+    FrameWorkspace* workspace;
+    while (input.pop(workspace)) {
+        if (!fusion_stage) {
+            (this->*stage)(*workspace);
+        } else if (!workspace->skipped) {
+            runFusionStage(stage, *workspace);
+        }
+        if (!output.push(workspace)) return;
+    }
+}
 
-int main(int argc, char** argv)
+// Real-time processing thread: runs the latest frame handed over by sync_callback
+void LidarCameraFusionNode::realtimeLoop()
 {
-    rclcpp::init(argc, argv);  // Initialize ROS2
-    auto node = std::make_shared<LidarCameraFusionNode>();  // Create node
-    rclcpp::spin(node);  // Run node
-    rclcpp::shutdown();  // Shutdown ROS2
-    return 0;
-}
\ No newline at end of file
+    while (true) {
+        sensor_msgs::msg::PointCloud2::ConstSharedPtr point_cloud_msg;
+        sensor_msgs::msg::Image::ConstSharedPtr image_msg;
+        yolo_msgs::msg::DetectionArray::ConstSharedPtr detection_msg;
+        realtime_wakeup_.wait();
+        if (realtime_stop_) return;
+        {
+            std::lock_guard<PriorityInheritanceMutex> lock(realtime_mutex_);
+            point_cloud_msg = std::move(pending_point_cloud_);
+            image_msg = std::move(pending_image_);
+            detection_msg = std::move(pending_detections_);
+        }
+        if (point_cloud_msg) processFrame(point_cloud_msg, image_msg, detection_msg);
+    }
+}
+
+// Refresh the cached extrinsics of every lidar/camera pair from TF without waiting (timer, off the hot path)
+void LidarCameraFusionNode::refreshExtrinsics()
+{
+    for (auto& camera : cameras_) {
+        Extrinsics extrinsics;
+        try {
+            for (const auto& lidar : lidars_) {
+                const auto lidar_to_camera = tf_buffer_.lookupTransform(camera->camera_frame, lidar->lidar_frame, tf2::TimePointZero);
+                StampedTransform stamped;
+                stamped.stamp = stampSeconds(lidar_to_camera);
+                stamped.transform = tf2::transformToEigen(lidar_to_camera);
+                extrinsics.lidar_to_camera.push_back(stamped);
+            }
+            const auto camera_to_lidar = tf_buffer_.lookupTransform(lidar_frame_, camera->camera_frame, tf2::TimePointZero);
+            extrinsics.camera_to_lidar.stamp = stampSeconds(camera_to_lidar);
+            extrinsics.camera_to_lidar.transform = tf2::transformToEigen(camera_to_lidar);
+        } catch (const tf2::TransformException& ex) {
+            RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Extrinsics not available yet: %s", ex.what());
+            continue;
+        }
+
+        // Append to a copy of the history, dropping the oldest entry once it is full. A lookup
+        // with no newer TF data than the last one (always the case for a static rig) replaces
+        // the last entry instead, so the history only holds distinct stamps.
+        auto history = std::make_shared<ExtrinsicsHistory>();
+        const auto current = camera->extrinsics.load();
+        if (current) {
+            *history = *current;
+            const Extrinsics& newest = history->back();
+            bool newer = extrinsics.camera_to_lidar.stamp > newest.camera_to_lidar.stamp;
+            for (size_t l = 0; l < lidars_.size(); ++l) {
+                newer = newer || extrinsics.lidar_to_camera[l].stamp > newest.lidar_to_camera[l].stamp;
+            }
+            if (!newer) {
+                history->pop_back();
+            } else if (history->size() == kExtrinsicsHistorySize) {
+                history->erase(history->begin());
+            }
+        }
+        history->push_back(std::move(extrinsics));
+        camera->extrinsics.store(std::move(history));
+    }
+}
+
+// Transform at stamp from an extrinsics history: interpolated between the entries around stamp,
+// the newest one when TF has no data for stamp yet, the oldest one before the history
+template <typename Select>
+LidarCameraFusionNode::UnalignedAffine3d LidarCameraFusionNode::extrinsicsAt(const ExtrinsicsHistory& history, double stamp, Select select)
+{
+    const StampedTransform* before = nullptr;
+    const StampedTransform* after = nullptr;
+    for (const auto& extrinsics : history) {
+        const StampedTransform& transform = select(extrinsics);
+        if (transform.stamp > stamp) {
+            after = &transform;
+            break;
+        }
+        before = &transform;
+    }
+    if (!before) return after->transform;
+    if (!after || after->stamp <= before->stamp) return before->transform;
+
+    // Rigid transforms: rotations are interpolated as quaternions, translations linearly
+    const double weight = (stamp - before->stamp) / (after->stamp - before->stamp);
+    const Eigen::Quaterniond rotation_before(before->transform.linear());
+    const Eigen::Quaterniond rotation_after(after->transform.linear());
+    UnalignedAffine3d transform = UnalignedAffine3d::Identity();
+    transform.linear() = rotation_before.slerp(weight, rotation_after).toRotationMatrix();
+    transform.translation() = (1.0 - weight) * before->transform.translation() + weight * after->transform.translation();
+    return transform;
+}
+
+// Count the frame and check its processing-path allocations once past the warm-up frames
+void LidarCameraFusionNode::recordFrameMetrics(uint64_t frame_allocations, uint64_t publish_allocations)
+{
+    const uint64_t frame = ++frames_processed_;
+    last_frame_allocations_ = frame_allocations;
+    last_publish_allocations_ = publish_allocations;
+
+    // Warm-up frames grow the workspaces to their working size and are expected to allocate
+    if (!AllocationCounter::enabled() || frame_allocations == 0 ||
+        frame <= static_cast<uint64_t>(allocation_check_warmup_frames_)) {
+        return;
+    }
+    allocating_frames_++;
+    if (frame_allocations > max_steady_state_allocations_) max_steady_state_allocations_ = frame_allocations;
+
+    // This runs on the processing threads, where an exception would terminate the whole
+    // process (every node of a container), so the failure is latched into the diagnostics
+    if (fail_on_steady_state_allocation_) {
+        uint64_t no_failure = 0;
+        if (failed_allocation_frame_.compare_exchange_strong(no_failure, frame)) {
+            RCLCPP_ERROR(get_logger(), "Steady-state frame %lu made %lu heap allocations, diagnostics report an error from now on",
+                         static_cast<unsigned long>(frame), static_cast<unsigned long>(frame_allocations));
+        }
+        return;
+    }
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Steady-state frame %lu made %lu heap allocations",
+                         static_cast<unsigned long>(frame), static_cast<unsigned long>(frame_allocations));
+}
+
+// Publish the frame and allocation metrics as diagnostics
+void LidarCameraFusionNode::publishMetrics()
+{
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = std::string(get_fully_qualified_name()) + ": fusion";  // Unique per robot namespace
+    status.hardware_id = lidar_frame_;
+    auto add_value = [&status](const std::string& key, const std::string& value) {
+        diagnostic_msgs::msg::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = value;
+        status.values.push_back(key_value);
+    };
+
+    add_value("frames", std::to_string(frames_processed_.load()));
+    add_value("allocation_counting", AllocationCounter::enabled() ? "enabled" : "disabled");
+    add_value("frame_allocations", std::to_string(last_frame_allocations_.load()));
+    add_value("publish_allocations", std::to_string(last_publish_allocations_.load()));
+    add_value("allocating_frames", std::to_string(allocating_frames_.load()));
+    add_value("max_steady_state_allocations", std::to_string(max_steady_state_allocations_.load()));
+    if (latency_budget_ > 0.0) {
+        add_value("late_dropped_frames", std::to_string(late_dropped_frames_.load()));
+        add_value("late_pose_only_frames", std::to_string(late_pose_only_frames_.load()));
+    }
+    if (decimation_controller_) {
+        add_value("decimation_stride", std::to_string(decimation_controller_->stride()));
+        add_value("processing_p99_ms", std::to_string(1000.0 * decimation_controller_->percentile()));
+    }
+    if (pipeline_ || realtime_) {
+        add_value("pipeline_full_frames", std::to_string(pipeline_full_frames_.load()));
+    }
+    if (realtime_) {
+        add_value("superseded_frames", std::to_string(superseded_frames_.load()));
+        add_value("oversized_frames", std::to_string(oversized_frames_.load()));
+        const bool extrinsics_cached = std::all_of(cameras_.begin(), cameras_.end(), [](const std::unique_ptr<Camera>& camera) {
+            return camera->extrinsics.load() != nullptr;
+        });
+        add_value("extrinsics_cached", extrinsics_cached ? "true" : "false");
+    }
+
+    const uint64_t failed_frame = failed_allocation_frame_.load();
+    if (failed_frame > 0) {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::ERROR;
+        status.message = "Steady-state frame " + std::to_string(failed_frame) + " allocated on the fusion path";
+    } else if (allocating_frames_ > 0) {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+        status.message = "Steady-state frames allocate on the fusion path";
+    } else {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+        status.message = "OK";
+    }
+
+    auto diagnostics = std::make_unique<diagnostic_msgs::msg::DiagnosticArray>();
+    diagnostics->header.stamp = now();
+    diagnostics->status.push_back(status);
+    metrics_publisher_->publish(std::move(diagnostics));
+}
+
+}  // namespace l2i_fusion_detection
+
+RCLCPP_COMPONENTS_REGISTER_NODE(l2i_fusion_detection::LidarCameraFusionNode)
@@ -0,0 +1,109 @@
+// Projection of plumb_bob and rational_polynomial cameras through the distortion map,
+// checked against the distortion polynomial evaluated per point.
+
+#include <gtest/gtest.h>
+
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "l2i_fusion_detection/camera_projection.hpp"
+
+namespace l2i_fusion_detection
+{
+
+namespace
+{
+
+// 640x480 camera with focal length f, principal point at the image center
+sensor_msgs::msg::CameraInfo makeCameraInfo(const std::string& distortion_model, const std::vector<double>& d, double f)
+{
+    sensor_msgs::msg::CameraInfo info;
+    info.width = 640;
+    info.height = 480;
+    info.distortion_model = distortion_model;
+    info.d = d;
+    info.k = {f, 0.0, 320.0, 0.0, f, 240.0, 0.0, 0.0, 1.0};
+    info.r = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+    info.p = {f, 0.0, 320.0, 0.0, 0.0, f, 240.0, 0.0, 0.0, 0.0, 1.0, 0.0};
+    return info;
+}
+
+// Distorted pixel of the normalized point (x, y), as image_geometry would compute it
+void distort(const sensor_msgs::msg::CameraInfo& info, double x, double y, double& u, double& v)
+{
+    auto d = [&](size_t i) { return i < info.d.size() ? info.d[i] : 0.0; };
+    const double r2 = x * x + y * y;
+    const double radial = (1.0 + r2 * (d(0) + r2 * (d(1) + r2 * d(4)))) / (1.0 + r2 * (d(5) + r2 * (d(6) + r2 * d(7))));
+    const double xd = x * radial + 2.0 * d(2) * x * y + d(3) * (r2 + 2.0 * x * x);
+    const double yd = y * radial + d(2) * (r2 + 2.0 * y * y) + 2.0 * d(3) * x * y;
+    u = info.k[0] * xd + info.k[1] * yd + info.k[2];
+    v = info.k[4] * yd + info.k[5];
+}
+
+// Largest distance between the map and the polynomial over points imaged inside the image
+double maxMapError(const sensor_msgs::msg::CameraInfo& info)
+{
+    CameraProjection projection;
+    EXPECT_TRUE(projection.fromCameraInfo(info));
+    EXPECT_EQ(projection.model(), CameraProjection::Model::DistortionMap);
+
+    double max_error = 0.0;
+    size_t imaged = 0;
+    for (double x = -1.5; x <= 1.5; x += 0.0123) {
+        for (double y = -1.2; y <= 1.2; y += 0.0117) {
+            double expected_u, expected_v;
+            distort(info, x, y, expected_u, expected_v);
+            if (expected_u < 0.0 || expected_u > info.width || expected_v < 0.0 || expected_v > info.height) continue;
+
+            const double z = 2.5;
+            double u, v;
+            if (!projection.project(x * z, y * z, z, u, v)) continue;
+            max_error = std::max(max_error, std::hypot(u - expected_u, v - expected_v));
+            imaged++;
+        }
+    }
+    EXPECT_GT(imaged, 10000u);
+    return max_error;
+}
+
+}  // namespace
+
+TEST(CameraProjectionTest, PlumbBobMapMatchesPolynomial)
+{
+    const auto info = makeCameraInfo("plumb_bob", {-0.28, 0.07, 0.0008, -0.0005, 0.0}, 400.0);
+    EXPECT_LE(maxMapError(info), 0.01);
+}
+
+TEST(CameraProjectionTest, RationalPolynomialMapMatchesPolynomial)
+{
+    const auto info = makeCameraInfo("rational_polynomial", {0.4, -0.05, 0.0005, 0.0002, 0.001, 0.75, 0.02, 0.003}, 450.0);
+    EXPECT_LE(maxMapError(info), 0.01);
+}
+
+TEST(CameraProjectionTest, PointsBeyondFoldBackAreNotImaged)
+{
+    // With k1 = -0.4 the distorted radius peaks at r = 0.913 and then folds back into the image
+    const auto info = makeCameraInfo("plumb_bob", {-0.4, 0.0, 0.0, 0.0, 0.0}, 300.0);
+    CameraProjection projection;
+    ASSERT_TRUE(projection.fromCameraInfo(info));
+
+    double u, v;
+    EXPECT_FALSE(projection.project(0.9, 0.9, 1.0, u, v));  // r = 1.27, diagonal
+    EXPECT_FALSE(projection.project(-1.2, 0.3, 1.0, u, v));
+    EXPECT_FALSE(projection.project(0.0, 1.0, 1.0, u, v));
+
+    // Points well inside the fold-back radius are still imaged, in every direction
+    for (int i = 0; i < 16; ++i) {
+        const double angle = i * 3.14159265358979323846 / 8;
+        const double x = 0.8 * std::cos(angle), y = 0.8 * std::sin(angle);
+        ASSERT_TRUE(projection.project(x, y, 1.0, u, v)) << "angle " << angle;
+        double expected_u, expected_v;
+        distort(info, x, y, expected_u, expected_v);
+        EXPECT_NEAR(u, expected_u, 0.01);
+        EXPECT_NEAR(v, expected_v, 0.01);
+    }
+}
+
+}  // namespace l2i_fusion_detection
@@ -0,0 +1,137 @@
+// Ground removal on synthetic organized scans: a 32-ring lidar 1.8 m above flat ground,
+// with obstacles given as axis-aligned boxes standing on the ground.
+
+#include <gtest/gtest.h>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "l2i_fusion_detection/ground_segmentation.hpp"
+
+namespace l2i_fusion_detection
+{
+
+namespace
+{
+
+constexpr double kSensorHeight = 1.8;
+constexpr double kMaxRange = 100.0;
+constexpr int kRings = 32;  // -25 to +6 degrees, 1 degree spacing
+constexpr int kColumns = 180;  // 2 degree spacing
+constexpr double kMaxSlopeDeg = 10.0;
+constexpr double kDistanceThreshold = 0.15;
+
+struct Box {
+    double min[3];
+    double max[3];
+};
+
+// Range along the ray from the origin to a box, or infinity if the ray misses it
+double intersect(const Box& box, const double direction[3])
+{
+    double t_near = 0.0, t_far = std::numeric_limits<double>::infinity();
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(direction[axis]) < 1e-12) {
+            if (0.0 < box.min[axis] || 0.0 > box.max[axis]) return std::numeric_limits<double>::infinity();
+            continue;
+        }
+        double t0 = box.min[axis] / direction[axis], t1 = box.max[axis] / direction[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        t_near = std::max(t_near, t0);
+        t_far = std::min(t_far, t1);
+    }
+    return t_near <= t_far ? t_near : std::numeric_limits<double>::infinity();
+}
+
+// Organized scan, row 0 being the lowest ring; rays that hit nothing within range are NaN
+// (kept by the ground removal, and dropped by the range crop)
+pcl::PointCloud<pcl::PointXYZ> makeScan(const std::vector<Box>& obstacles)
+{
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    cloud.width = kColumns;
+    cloud.height = kRings;
+    cloud.points.resize(static_cast<size_t>(kColumns) * kRings);
+    for (int ring = 0; ring < kRings; ++ring) {
+        const double elevation = (-25.0 + ring) * M_PI / 180.0;
+        for (int col = 0; col < kColumns; ++col) {
+            const double azimuth = (-180.0 + 2.0 * col) * M_PI / 180.0;
+            const double direction[3] = {
+                std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth), std::sin(elevation)};
+            double range = direction[2] < 0.0 ? kSensorHeight / -direction[2] : std::numeric_limits<double>::infinity();
+            for (const auto& box : obstacles) range = std::min(range, intersect(box, direction));
+
+            auto& point = cloud.points[static_cast<size_t>(ring) * kColumns + col];
+            if (range > kMaxRange) {
+                point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+            } else {
+                point.x = static_cast<float>(range * direction[0]);
+                point.y = static_cast<float>(range * direction[1]);
+                point.z = static_cast<float>(range * direction[2]);
+            }
+        }
+    }
+    return cloud;
+}
+
+bool onGround(const pcl::PointXYZ& point)
+{
+    return std::isfinite(point.z) && std::abs(point.z + kSensorHeight) < 1e-3;
+}
+
+// Returns higher than twice the distance threshold above the ground
+size_t countElevated(const pcl::PointCloud<pcl::PointXYZ>& cloud)
+{
+    return static_cast<size_t>(std::count_if(cloud.points.begin(), cloud.points.end(), [](const pcl::PointXYZ& point) {
+        return std::isfinite(point.z) && point.z > -kSensorHeight + 2.0 * kDistanceThreshold;
+    }));
+}
+
+size_t countGround(const pcl::PointCloud<pcl::PointXYZ>& cloud)
+{
+    return static_cast<size_t>(std::count_if(cloud.points.begin(), cloud.points.end(), onGround));
+}
+
+}  // namespace
+
+TEST(GroundSegmentationTest, FlatGroundIsRemoved)
+{
+    auto cloud = makeScan({});
+    ASSERT_GT(countGround(cloud), 0u);
+
+    GroundSegmentation segmentation(kMaxSlopeDeg, kDistanceThreshold, 25, 2000);
+    segmentation.removeGround(cloud);
+    EXPECT_EQ(countGround(cloud), 0u);
+}
+
+TEST(GroundSegmentationTest, StandingObstacleIsKept)
+{
+    // A 1.8 m tall person 5 m ahead of the sensor
+    const Box person{{5.0, -0.3, -kSensorHeight}, {5.3, 0.3, 0.0}};
+    auto cloud = makeScan({person});
+    const size_t elevated = countElevated(cloud);
+    ASSERT_GT(elevated, 10u);
+
+    GroundSegmentation segmentation(kMaxSlopeDeg, kDistanceThreshold, 25, 2000);
+    segmentation.removeGround(cloud);
+    EXPECT_EQ(countGround(cloud), 0u);
+    EXPECT_EQ(countElevated(cloud), elevated);
+}
+
+TEST(GroundSegmentationTest, WallInFrontOfTheLowestRingIsKept)
+{
+    // A wall 2 m ahead that the lowest ring already hits, well above the ground
+    const Box wall{{2.0, -1.0, -kSensorHeight}, {2.2, 1.0, 1.0}};
+    auto cloud = makeScan({wall});
+    const size_t elevated = countElevated(cloud);
+    ASSERT_GT(elevated, 10u);
+
+    GroundSegmentation segmentation(kMaxSlopeDeg, kDistanceThreshold, 25, 2000);
+    segmentation.removeGround(cloud);
+    EXPECT_EQ(countGround(cloud), 0u);
+    EXPECT_EQ(countElevated(cloud), elevated);
+}
+
+}  // namespace l2i_fusion_detection
@@ -0,0 +1,170 @@
+// Runs synthetic frames through the fusion path of a node linked with the counting allocation
+// functions and checks that no frame after the warm-up allocates.
+
+#include <gtest/gtest.h>
+
+#include <rclcpp/rclcpp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "l2i_fusion_detection/allocation_counter.hpp"
+#include "l2i_fusion_detection/lidar_camera_fusion_node.hpp"
+
+namespace l2i_fusion_detection
+{
+
+namespace
+{
+constexpr int kWarmupFrames = 5;  // Frames allowed to allocate while the buffers grow
+constexpr int kFrames = 30;
+}  // namespace
+
+class SteadyStateAllocationTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+    static void TearDownTestCase() { rclcpp::shutdown(); }
+
+    // Node in real-time mode, so that transforms come from the extrinsics cache rather than
+    // TF; the cache is filled with identity transforms (lidar and camera frames coincide)
+    static std::shared_ptr<LidarCameraFusionNode> makeNode(const std::vector<rclcpp::Parameter>& parameters)
+    {
+        std::vector<rclcpp::Parameter> overrides{
+            rclcpp::Parameter("realtime", true),
+            rclcpp::Parameter("allocation_check_warmup_frames", kWarmupFrames)};
+        overrides.insert(overrides.end(), parameters.begin(), parameters.end());
+        auto node = std::make_shared<LidarCameraFusionNode>(rclcpp::NodeOptions().parameter_overrides(overrides));
+
+        // 640x480 pinhole camera, f = 500 px
+        auto camera_info = std::make_shared<sensor_msgs::msg::CameraInfo>();
+        camera_info->width = 640;
+        camera_info->height = 480;
+        camera_info->distortion_model = "plumb_bob";
+        camera_info->d = {0.0, 0.0, 0.0, 0.0, 0.0};
+        camera_info->k = {500.0, 0.0, 320.0, 0.0, 500.0, 240.0, 0.0, 0.0, 1.0};
+        camera_info->r = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+        camera_info->p = {500.0, 0.0, 320.0, 0.0, 0.0, 500.0, 240.0, 0.0, 0.0, 0.0, 1.0, 0.0};
+        node->camera_info_callback(camera_info, *node->cameras_[0]);
+
+        auto history = std::make_shared<LidarCameraFusionNode::ExtrinsicsHistory>(1);
+        history->back().lidar_to_camera.resize(1);  // Static identity transforms
+        node->cameras_[0]->extrinsics.store(std::move(history));
+        return node;
+    }
+
+    // Organized xyz cloud: a wall 4 m in front of the camera, inside the crop box
+    static sensor_msgs::msg::PointCloud2::ConstSharedPtr makeCloud(int frame)
+    {
+        auto cloud = std::make_shared<sensor_msgs::msg::PointCloud2>();
+        cloud->header.stamp = rclcpp::Time(frame, 0);
+        cloud->header.frame_id = "lidar";
+        cloud->height = 32;
+        cloud->width = 64;
+        const char* names[] = {"x", "y", "z"};
+        for (uint32_t i = 0; i < 3; ++i) {
+            sensor_msgs::msg::PointField field;
+            field.name = names[i];
+            field.offset = 4 * i;
+            field.datatype = sensor_msgs::msg::PointField::FLOAT32;
+            field.count = 1;
+            cloud->fields.push_back(field);
+        }
+        cloud->point_step = 16;
+        cloud->row_step = cloud->point_step * cloud->width;
+        cloud->data.resize(static_cast<size_t>(cloud->row_step) * cloud->height);
+        for (uint32_t row = 0; row < cloud->height; ++row) {
+            for (uint32_t col = 0; col < cloud->width; ++col) {
+                const float point[3] = {0.5f + 0.02f * col, -0.5f + 0.03f * row, 4.0f};
+                std::memcpy(&cloud->data[row * cloud->row_step + col * cloud->point_step], point, sizeof(point));
+            }
+        }
+        return cloud;
+    }
+
+    static sensor_msgs::msg::Image::ConstSharedPtr makeImage(int frame)
+    {
+        auto image = std::make_shared<sensor_msgs::msg::Image>();
+        image->header.stamp = rclcpp::Time(frame, 0);
+        image->header.frame_id = "camera";
+        image->height = 480;
+        image->width = 640;
+        image->encoding = "bgr8";
+        image->step = 3 * image->width;
+        image->data.resize(static_cast<size_t>(image->step) * image->height);
+        return image;
+    }
+
+    // Two boxes covering the projected wall, and one that no point falls into. The node flips
+    // both image axes, so the wall lands at u = 100..258 and v = 186..302
+    static yolo_msgs::msg::DetectionArray::ConstSharedPtr makeDetections(int frame)
+    {
+        auto detections = std::make_shared<yolo_msgs::msg::DetectionArray>();
+        detections->header.stamp = rclcpp::Time(frame, 0);
+        const double boxes[3][4] = {{180.0, 240.0, 80.0, 80.0}, {230.0, 270.0, 40.0, 40.0}, {520.0, 80.0, 40.0, 40.0}};
+        for (int i = 0; i < 3; ++i) {
+            yolo_msgs::msg::Detection detection;
+            detection.id = std::to_string(i + 1);
+            detection.class_id = i;
+            detection.bbox.center.position.x = boxes[i][0];
+            detection.bbox.center.position.y = boxes[i][1];
+            detection.bbox.size.x = boxes[i][2];
+            detection.bbox.size.y = boxes[i][3];
+            detections->detections.push_back(detection);
+        }
+        return detections;
+    }
+
+    // Run frames through processFrame and expect no allocations once past the warm-up
+    static void expectSteadyStateWithoutAllocations(LidarCameraFusionNode& node)
+    {
+        ASSERT_TRUE(AllocationCounter::enabled());
+        for (int frame = 1; frame <= kFrames; ++frame) {
+            // The inputs are built before the frame, as the middleware would deliver them
+            const auto cloud = makeCloud(frame);
+            const auto image = makeImage(frame);
+            const auto detections = makeDetections(frame);
+            node.processFrame(cloud, image, detections);
+
+            // Real-time mode publishes the frame, and records its metrics, on the publish thread
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (node.frames_processed_.load() < static_cast<uint64_t>(frame) && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            ASSERT_EQ(node.frames_processed_.load(), static_cast<uint64_t>(frame));
+            if (frame > kWarmupFrames) {
+                EXPECT_EQ(node.last_frame_allocations_.load(), 0u) << "frame " << frame;
+            }
+        }
+        EXPECT_EQ(node.frames_processed_.load(), static_cast<uint64_t>(kFrames));
+        EXPECT_EQ(node.allocating_frames_.load(), 0u);
+
+        // Every workspace has been used by now and still holds the boxes of its last frame
+        for (const auto& workspace : node.frame_workspaces_) {
+            const auto& bounding_boxes = workspace.cameras[0].bounding_boxes;
+            ASSERT_EQ(bounding_boxes.size(), 3u);
+            EXPECT_GT(bounding_boxes[0].count, 0);
+            EXPECT_GT(bounding_boxes[1].count, 0);
+            EXPECT_EQ(bounding_boxes[2].count, 0);
+        }
+    }
+};
+
+TEST_F(SteadyStateAllocationTest, BoundingBoxAssociation)
+{
+    auto node = makeNode({});
+    expectSteadyStateWithoutAllocations(*node);
+}
+
+TEST_F(SteadyStateAllocationTest, ClusteringAndDownsampling)
+{
+    auto node = makeNode({
+        rclcpp::Parameter("use_clustering", true),
+        rclcpp::Parameter("object_cloud_leaf_size", 0.1)});
+    expectSteadyStateWithoutAllocations(*node);
+}
+
+}  // namespace l2i_fusion_detection